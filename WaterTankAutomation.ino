@@ -1,287 +1,3574 @@
+#if defined(ESP32)
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <AsyncTCP.h>
+#include <HTTPClient.h>
+#include <Update.h>
+#include <mbedtls/md.h>
+#include <mbedtls/pk.h>
+#include <freertos/semphr.h>
+#else
 #include <ESP8266WiFi.h>
+#include <ESPAsyncTCP.h>
+#include <ESP8266HTTPClient.h>
+#include <Updater.h>
+#include <coredecls.h>
+#include <gpio.h>
+#endif
 #include <EEPROM.h>
-#include <WiFiManager.h>
+#include <LittleFS.h>
+#include <DNSServer.h>
 #include <PubSubClient.h>
-#include <ESP8266WebServer.h>
+#include <ESPAsyncWebServer.h>
+#include <time.h>
+#include "web_assets.h"
+#include "src/board_profiles.h"
+#include "src/config_store.h"
+#include "src/flow_meter.h"
+#include "src/mqtt_commands.h"
+#include "src/ota_manifest.h"
+#include "src/pump_control.h"
+#include "src/schedule.h"
+#include "src/sensor_filter.h"
+#include "src/spsc_queue.h"
+#include "src/wifi_cache.h"
 
-// GPIO Pins
-#define LOW_SENSOR_PIN 4  // D2
-#define HIGH_SENSOR_PIN 5 // D1
-#define RELAY_PIN 14      // D5
-#define LED_PIN 2         // D4 (Built-in LED, active low)
+// OTA updates are only accepted with a signing key built in. The header is
+// written by `tools/ota_sign.py genkey` and defines OTA_PUBLIC_KEY.
+#if __has_include("ota_key.h")
+#include "ota_key.h"
+#define OTA_ENABLED 1
+#else
+#define OTA_ENABLED 0
+#endif
 
+// MQTT over TLS can pin the broker certificate's fingerprint (set on the
+// setup page) or validate it against a CA built in from mqtt_ca.h, which
+// defines MQTT_CA_CERT as a PEM string in PROGMEM.
+#if __has_include("mqtt_ca.h")
+#include "mqtt_ca.h"
+#define MQTT_CA_ENABLED 1
+#else
+#define MQTT_CA_ENABLED 0
+#endif
 
-// EEPROM Addresses
+// Tank channels. 1 runs the main tank only; 2 adds a rooftop tank filled
+// by a transfer pump from the main tank. On boards where the second channel
+// takes the ultrasonic sensor's pins, the main tank then uses floats or the
+// ADC.
+#ifndef TANK_CHANNELS
+#define TANK_CHANNELS 1
+#endif
+
+// GPIO pins and relay/LED polarity come from the board profile (BOARD),
+// chosen with -DBOARD_PROFILE, see src/board_profiles.h. On the ESP8266
+// boards the flow meter is on RX, so Serial runs TX-only.
+#define LEVEL_ADC_PIN A0  // Pressure transducer, scaled to 0-1 V (ESP8266) or 0-3.3 V (ESP32)
+
+// ESP32 builds split the scheduler over the two cores (see Task.group):
+// the control tasks, which read the sensors and switch the pumps, run in a
+// FreeRTOS task of their own on CONTROL_CORE, so a TLS handshake or a slow
+// flash write on NETWORK_CORE, next to the WiFi stack and AsyncTCP, can no
+// longer delay a pump decision. The two sides share state through
+// controlQueue and eventQueue. The ESP8266 runs both groups from loop().
+#define CONTROL_CORE 1
+#define NETWORK_CORE 0
+#define CONTROL_TASK_PRIORITY 10  // Above Arduino's loop task and AsyncTCP (3)
+#define NETWORK_TASK_PRIORITY 1   // Same as Arduino's loop task
+#define CONTROL_TASK_STACK 4096
+#define NETWORK_TASK_STACK 12288  // A TLS handshake runs on this stack
+#define CONTROL_QUEUE_SIZE 16     // Commands waiting for the control side
+#define EVENT_QUEUE_SIZE 32       // Event records waiting for taskEventLog()
+
+// Legacy EEPROM layout, only read to migrate units flashed with older firmware
 #define EEPROM_SIZE 256
 #define WIFI_SSID_ADDR 100
 #define WIFI_PASS_ADDR 140
 #define MQTT_ADDR 0
 
-WiFiManager wifiManager;
+// Config store (LittleFS), record layout in src/config_store.h
+#define CONFIG_SLOT_A "/config_a.bin"
+#define CONFIG_SLOT_B "/config_b.bin"
+
+// Event log (LittleFS ring of fixed-size pages, one small file per page slot)
+#define EVENT_LOG_PAGES 32            // 8 KB ring, several weeks of typical pump cycles
+#define EVENT_PAGE_SIZE 256
+#define EVENT_PAGE_MAGIC 0x5645       // "EV"
+#define EVENT_FLUSH_MS 300000UL       // A partly filled page is written at least this often
+
+// Continuous level sensors
+#define LEVEL_MEDIAN_SIZE 5     // Raw readings in the median filter
+#define LEVEL_EMA_WEIGHT 0.25f  // Weight of each new median in the moving average
+#define LEVEL_HYSTERESIS 2      // % either side of a threshold before its virtual float flips
+#define LEVEL_REPORT_STEP 2     // % change before the level counts as a status change
+#define LEVEL_MAX_MISSES 5      // Consecutive bad readings before the sensor is faulted
+#define LEVEL_RANGE_MARGIN 10   // % outside the calibrated range that still counts as valid
+
+// Runtime statistics
+#define STATS_BUCKET_MS 300000UL        // Cycles/hour counts starts in 12 buckets of 5 minutes
+#define STATS_BUCKETS 12
+#define STATS_MIN_FILLS 5               // Fills needed before the mean is trusted
+#define STATS_LONG_FILL_FACTOR 3.0f     // A fill taking this many times the mean is flagged
+
+// Flow meter on the main tank's pump (hall-effect, pulses counted by
+// onFlowPulse(); accounting in src/flow_meter.h)
+#define FLOW_PRIME_MS 10000UL      // Pump may run this long before water has to move
+#define FLOW_NO_FLOW_MS 5000UL     // Longest gap between pulses while the pump runs
+#define FLOW_RETRY_MS 1800000UL    // A no-flow fault is retried after 30 minutes
+#define FLOW_REPORT_STEP 500       // mL/min change before the rate counts as a status change
+
+// Sensor sampler (hardware timer1 on the ESP8266, timer 0 on the ESP32)
+#define SAMPLE_INTERVAL_US 5000  // 200 Hz per pin
+#define TIMER1_TICKS_PER_US 5    // 80 MHz APB clock / TIM_DIV16
+#define ESP32_TIMER_DIVIDER 80   // 80 MHz APB clock / 80, one tick per us
+
+// Pump control
+#define PUMP_MIN_RUN_MS 10000UL   // Pump stays ON at least this long once started
+#define PUMP_MIN_REST_MS 30000UL  // Pump stays OFF at least this long once stopped
+
+// Pumping schedule (rules in the config store, see src/schedule.h)
+#define CLOCK_VALID_AFTER 1600000000L  // time() below this means NTP has not set the clock yet
+
+// Power management. The configured latency (power_latency_ms) bounds how
+// long a command may wait while the unit sleeps; it sets the DTIM listen
+// interval and, in light sleep, how often the tasks run.
+#define POWER_LATENCY_MIN_MS 100
+#define POWER_LATENCY_MAX_MS 10000
+#define POWER_BEACON_MS 102      // One beacon interval (100 TU)
+#define POWER_LISTEN_MAX 10      // Longest listen interval the SDK accepts, in beacons
+#define POWER_SETTLE_MS 200      // Awake with the sampler running after a float wakes the unit
+
+// MQTT connection
+#define MQTT_KEEPALIVE_S 15           // While always on; stretched with the sleep latency otherwise
+#define MQTT_DNS_TIMEOUT_MS 500       // Bounds the broker name lookup
+#define MQTT_CONNECT_TIMEOUT_MS 500   // Bounds the TCP connect
+#define MQTT_SOCKET_TIMEOUT_S 1       // Bounds the wait for CONNACK, the shortest PubSubClient takes
+#define MQTT_BACKOFF_MIN_MS 1000UL
+#define MQTT_BACKOFF_MAX_MS 60000UL
+
+// MQTT over TLS. A full handshake costs a second or more of blocked loop and
+// ~20 kB of heap, so on the ESP8266 the session is cached and later
+// reconnects resume it (one round trip, no public-key operations). The
+// receive buffer must hold a whole TLS record: 16 kB unless the broker
+// agrees to the smaller Maximum Fragment Length, probed per broker setting
+// until the broker has answered. The ESP32's mbedTLS client does neither,
+// and has the heap and a core to itself for the full handshake.
+#define MQTT_TLS_TIMEOUT_MS 3000  // Bounds DNS + TCP + each handshake read
+#define MQTT_TLS_RX_MFLN 1024     // Receive buffer after a successful MFLN probe
+#define MQTT_TLS_RX_FULL 16384    // ... without MFLN, the largest TLS record
+#define MQTT_TLS_TX 1024          // Holds a full MQTT_BUFFER_SIZE packet
+
+// MQTT topics. Each unit has its own namespace, mqttBase =
+// "<prefix>/<device id>/", for its commands, telemetry, acks and
+// availability. Commands are also taken from "<prefix>/all/", sent to every
+// unit, and "<prefix>/group/<group>/" when the unit is in a group.
+#define MQTT_TOPIC_MAX 96
+#define MQTT_BROADCAST "all"
+#define MQTT_AVAILABILITY "availability"  // Retained "online"; the broker sets "offline" as the last will
+
+// MQTT telemetry
+#define TELEMETRY_HEARTBEAT_MS 60000UL  // Health frame (RSSI, heap, uptime) period
+#define MQTT_BUFFER_SIZE 512            // Room for the metrics frame
+
+// Soak testing. Build with -DSOAK_TEST=1 and drive the unit with
+// tools/soak.py; the unit records heap, fragmentation, loop latency and link
+// counters per window and serves them at /soak.json.
+#ifndef SOAK_TEST
+#define SOAK_TEST 0
+#endif
+#define SOAK_WINDOW_MS 60000UL  // One sample per window
+#define SOAK_SAMPLES 240        // Windows kept, four hours at the default
+
+// Logging
+// Levels above LOG_LEVEL are compiled out, arguments and all. Override with
+// -DLOG_LEVEL=LOG_LEVEL_DEBUG in the build flags.
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_WARN 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#define LOG_RING_SIZE 32           // Entries kept for draining and for /log
+#define LOG_MESSAGE_MAX 80
+#define LOG_MQTT_LEVEL LOG_LEVEL_WARN  // Entries this severe or worse also go to MQTT
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logPrintf(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) logPrintf(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) logPrintf(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logPrintf(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
+
+// Dashboard push (WebSocket at /ws)
+#define WS_MAX_CLIENTS 4  // Oldest connections are dropped beyond this
+
+// Firmware updates
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION "1.0.0"
+#endif
+#define OTA_STATE_FILE "/ota.bin"
+#define OTA_MAGIC 0x41544F57UL          // "WOTA"
+#define OTA_MANIFEST_MAX 2048           // Longest URLs plus an RSA-4096 signature in hex
+#define OTA_HTTP_TIMEOUT_MS 3000
+#define OTA_CHUNK_SIZE 1024             // Bytes moved to flash per task pass
+#define OTA_STALL_MS 15000UL            // Download abandoned after this long without data
+#define OTA_RETRY_MS 60000UL            // Wait before retrying a failed rollback
+#define OTA_HEALTH_MIN_MS 60000UL       // A new image is kept once it has run this long with MQTT up
+#define OTA_HEALTH_TIMEOUT_MS 600000UL  // ... and rolled back if it has not got there by now
+#define OTA_MAX_TRIAL_BOOTS 3           // ... or if it restarted this often on trial
+
+// WiFi connection
+#define WIFI_AP_SSID "WaterTank-Setup"
+#define WIFI_AP_FALLBACK_MS 15000UL  // Open the setup AP when STA has been down this long
+#define WIFI_CACHE_PATH "/wifi_cache.bin"  // Fast-join record, see src/wifi_cache.h
+#define WIFI_FAST_JOIN_MS 3000UL     // A cached join with no IP by then falls back to scan + DHCP
+#define WIFI_CACHE_RENEW_MS 3600000UL  // A cached address is renewed over DHCP after this long online
+#define CAPTIVE_DNS_PORT 53
+
+DNSServer captiveDns;  // While the setup AP is up, answers every name with the AP's address
 WiFiClient espClient;
-PubSubClient client(espClient);
-ESP8266WebServer server(80);
-
-char wifi_ssid[40] = "";
-char wifi_password[40] = "";
-char mqtt_server[40] = "";
-char mqtt_user[20] = "";
-char mqtt_password[20] = "";
-int mqtt_port = 1883;
-
-bool overrideMode = false;
-bool overrideState = false;
+#if defined(ESP32)
+WiFiClientSecure tlsClient;
+#else
+BearSSL::WiFiClientSecure tlsClient;
+BearSSL::Session tlsSession;  // Resumed by each reconnect to the same broker
+#if MQTT_CA_ENABLED
+BearSSL::X509List tlsTrustAnchors(MQTT_CA_CERT);
+#endif
+#endif
+PubSubClient client(espClient);  // Moved to tlsClient by applyMqttConfig() when TLS is on
+AsyncWebServer server(80);
+AsyncWebSocket ws("/ws");  // Dashboard push channel
+
+Config config = CONFIG_DEFAULTS;  // RAM copy everything reads from
+Config storedConfig;              // What the current record holds, to skip no-op saves
+Config pendingConfig;             // Posted to /save, applied by taskWeb()
+bool configSavePending = false;
+
+// On the ESP32 the web handlers run in the AsyncTCP task, which preempts
+// the networking task: pendingConfig, and config while taskWeb() replaces
+// it, are only touched with configLock held. The control core reads config
+// only under it too, to take its ControlSettings. The ESP8266 never
+// preempts.
+#if defined(ESP32)
+SemaphoreHandle_t configLock;
+#define CONFIG_LOCK() xSemaphoreTake(configLock, portMAX_DELAY)
+#define CONFIG_UNLOCK() xSemaphoreGive(configLock)
+#else
+#define CONFIG_LOCK() do {} while (0)
+#define CONFIG_UNLOCK() do {} while (0)
+#endif
+uint32_t configSequence = 0;
+bool configInSlotA = false;
+
+// The settings the control side works from. On the ESP32 the network core
+// may replace `config` at any moment, so the control side never touches
+// it: copyControlSettings() takes this copy under configLock at boot and
+// whenever a settings command arrives (see ControlCommandType).
+struct ControlSettings {
+  uint8_t sensorType;  // Already checked by checkLevelSensorSetting()
+  uint8_t levelStart;
+  uint8_t levelStop;
+  uint16_t calEmpty;
+  uint16_t calFull;
+  uint16_t flowPulsesPerLitre;
+  ScheduleRule schedule[SCHEDULE_RULES];
+};
+ControlSettings controlSettings;
+
 bool apMode = false;
 bool mqttConfigured = false;
-bool mqttSkipped = false;
+
+enum MqttTlsMode { MQTT_TLS_OFF, MQTT_TLS_FINGERPRINT, MQTT_TLS_CA };
+const char *const MQTT_TLS_NAMES[] = { "off", "fingerprint", "ca" };
+bool tlsProbePending = false;  // MFLN answer not yet known for this broker
+bool tlsProbeTaken = false;    // This attempt spent its first step on the probe
+
+// WiFi state machine, driven by the SDK station events.
+//   CONNECTING  STA joining (or re-joining) the configured network
+//   ONLINE      STA has an IP; setup AP is off
+//   AP_FALLBACK STA still retrying in the background, setup AP open (AP+STA)
+enum WifiState { WIFI_CONNECTING, WIFI_ONLINE, WIFI_AP_FALLBACK };
+const char *const WIFI_STATE_NAMES[] = { "CONNECTING", "ONLINE", "AP_FALLBACK" };
+
+WifiState wifiState = WIFI_CONNECTING;
+unsigned long wifiStateSince = 0;
+#if !defined(ESP32)
+WiFiEventHandler wifiGotIPHandler;
+WiFiEventHandler wifiDisconnectedHandler;
+#endif
+volatile bool wifiGotIPEvent = false;         // Set from the SDK event callbacks,
+volatile bool wifiDisconnectedEvent = false;  // consumed by taskWiFi()
+WifiCache wifiCache;        // Last good join, loaded by startWiFi()
+bool wifiFastJoin = false;  // The station was started from wifiCache
+
+bool mqttWasConnected = false;
+unsigned long mqttBackoff = MQTT_BACKOFF_MIN_MS;  // Current retry delay, doubles per failure
+unsigned long mqttNextAttempt = 0;                // millis() of the next connect attempt
+
+// Log ring buffer. logHead counts every entry ever written; each sink keeps
+// its own running index and drains at its own pace. A sink that falls more
+// than LOG_RING_SIZE behind skips ahead and reports how many it lost. Both
+// cores log on the ESP32, so entries are written and copied out under a
+// spinlock there; messages are formatted outside it.
+struct LogEntry {
+  unsigned long time;
+  uint8_t level;
+  char message[LOG_MESSAGE_MAX];
+};
+
+const char LOG_LEVEL_CHARS[] = "EWID";
+
+LogEntry logRing[LOG_RING_SIZE];
+uint32_t logHead = 0;
+uint32_t logSerialTail = 0;
+uint32_t logMqttTail = 0;
+uint16_t logRepeats = 0;  // Copies of the newest entry swallowed since it was written
+
+#if defined(ESP32)
+portMUX_TYPE logRingLock = portMUX_INITIALIZER_UNLOCKED;
+#define LOG_RING_LOCK() portENTER_CRITICAL(&logRingLock)
+#define LOG_RING_UNLOCK() portEXIT_CRITICAL(&logRingLock)
+#else
+#define LOG_RING_LOCK() do {} while (0)
+#define LOG_RING_UNLOCK() do {} while (0)
+#endif
+
+// Power policy, chosen in the setup page.
+//   ALWAYS_ON    radio and CPU never sleep; lowest command latency
+//   MODEM_SLEEP  radio sleeps between DTIM beacons, CPU idles between tasks
+//   LIGHT_SLEEP  as MODEM_SLEEP, and while the pump is idle the CPU light
+//                sleeps too: the float sampler stops, every task runs once
+//                per power_latency_ms, and a float changing level wakes it.
+//                ESP8266 only; the ESP32 treats it as MODEM_SLEEP
+enum PowerMode : uint8_t { POWER_ALWAYS_ON, POWER_MODEM_SLEEP, POWER_LIGHT_SLEEP };
+const char *const POWER_MODE_NAMES[] = { "always_on", "modem_sleep", "light_sleep" };
+
+bool powerSleeping = false;                // In light sleep, see setPowerSleeping()
+volatile bool powerWakeRequested = false;  // Set by onFloatWake() and pollFloatsAsleep()
+unsigned long powerAwakeUntil = 0;         // Light sleep is held off until then
+uint32_t powerIdleMs = 0;                  // Time spent waiting in idleUntilNextTask()
+
+// Firmware update. An MQTT "ota" command names a manifest URL; the signed
+// manifest (see src/ota_manifest.h) names the image. The image is streamed
+// into the free flash above the running sketch one chunk per task pass, so
+// the sensor and pump tasks keep running, and is checked against the
+// manifest's SHA-256 and MD5 before the bootloader is told to copy it in.
+// Only a version newer than the running one is installed. Gzip'd images
+// are accepted as-is on the ESP8266; the ESP32 needs them uncompressed. The
+// restart waits until the pump is off.
+//
+// The ESP8266 has no second bank to fall back on once the copy is done, so
+// rollback means reinstalling: the new image is on trial until it has run
+// OTA_HEALTH_MIN_MS with MQTT connected. If it crash-loops or never gets
+// there, the rollback image named in its manifest is installed the same way.
+enum OtaState { OTA_IDLE, OTA_CHECK, OTA_DOWNLOAD, OTA_RESTART };
+
+// Kept in OTA_STATE_FILE across the restart into a new image.
+struct OtaRecord {
+  uint32_t magic;
+  uint8_t trial;  // 1 while the image is unconfirmed
+  uint8_t boots;  // Boots of the unconfirmed image
+  char version[OTA_VERSION_MAX];
+  char rollbackUrl[OTA_URL_MAX];
+  char rollbackMd5[OTA_MD5_HEX + 1];
+  char rollbackSha256[OTA_SHA256_HEX + 1];
+};
+
+OtaState otaState = OTA_IDLE;
+OtaRecord otaRecord = {};
+OtaRecord otaNextRecord = {};      // Written once the download verifies
+char otaManifestUrl[OTA_URL_MAX];  // From the MQTT command
+WiFiClient otaClient;
+HTTPClient otaHttp;
+size_t otaRemaining = 0;           // Image bytes still to download
+uint8_t otaSha256[32];             // Expected digest of the image
+#if defined(ESP32)
+mbedtls_md_context_t otaHash;      // Of the image bytes downloaded so far
+#else
+BearSSL::HashSHA256 otaHash;
+#endif
+unsigned long otaProgressAt = 0;   // millis() data last arrived
+unsigned long otaRetryAt = 0;
+
+// Produces the next piece of a streamed HTTP response into `buffer` (at
+// most `size` bytes) and returns its length, or 0 once there is no more.
+typedef std::function<size_t(uint8_t *buffer, size_t size)> ChunkSource;
+#define WEB_PIECE_MAX EVENT_PAGE_SIZE  // Largest piece a ChunkSource is asked for
+
+// Event log. Records are packed into 256-byte pages: a header carrying the
+// absolute time of the page's first record, then 4-byte records whose
+// timestamp is the number of seconds since the previous record. A type
+// that carries a value (eventHasValue()) is followed in the same page by a
+// 4-byte continuation slot holding it as a raw uint32_t. Pages are
+// filled in RAM and written whole (or every EVENT_FLUSH_MS when partly
+// filled) to /evNN.bin, NN = sequence % EVENT_LOG_PAGES. Small whole-file
+// writes let LittleFS spread the wear instead of rewriting one big file.
+enum EventType : uint8_t {
+  EVENT_BOOT,
+  EVENT_PUMP_ON,
+  EVENT_PUMP_OFF,
+  EVENT_STATE,     // Pump state machine transition
+  EVENT_SENSORS,   // Filtered float switch edge
+  EVENT_OVERRIDE,  // Override command received
+  EVENT_LONG_FILL, // Fill running STATS_LONG_FILL_FACTOR times longer than the mean
+  EVENT_SCHEDULE,  // Schedule window opened or closed
+  EVENT_NO_FLOW,   // Pump ran without the flow meter seeing water
+  EVENT_FILL_VOLUME,  // Pump run ended; value is the volume it moved, mL
+};
+#define EVENT_TYPE_MASK 0x0F  // EventRecord.type: EventType, channel in the high nibble
+const char *const EVENT_TYPE_NAMES[] = { "BOOT", "PUMP_ON", "PUMP_OFF", "STATE", "SENSORS", "OVERRIDE", "LONG_FILL", "SCHEDULE",
+                                         "NO_FLOW", "FILL_VOLUME" };
+
+struct EventRecord {
+  uint16_t delta;  // Seconds since the previous record (or the page base)
+  uint8_t type;    // bits0-3 EventType, bits4-7 channel
+  uint8_t bits;    // That channel's bit0 low WET, bit1 high WET, bit2 pump ON, bit3 override, bits4-7 PumpState
+};
+
+struct EventPageHeader {
+  uint16_t magic;
+  uint16_t boot;       // Boot counter, so uptimes from different boots stay apart
+  uint32_t sequence;   // Page number since the log was created
+  uint32_t baseTime;   // Uptime in seconds of the page's first record
+  uint8_t count;       // Records used
+  uint8_t reserved[3];
+};
+
+const size_t EVENT_PAGE_RECORDS = (EVENT_PAGE_SIZE - sizeof(EventPageHeader)) / sizeof(EventRecord);
+
+struct EventPage {
+  EventPageHeader header;
+  EventRecord records[EVENT_PAGE_RECORDS];
+};
+
+static_assert(sizeof(EventPage) == EVENT_PAGE_SIZE, "EventPage must fill a page exactly");
+
+// Position in the log while a response streams it, oldest page first.
+struct EventCursor {
+  uint32_t sequence;  // Page being read
+  bool loaded;        // `page` holds a copy of it
+  EventPage page;
+  uint8_t record;     // Next record in `page`
+  uint32_t time;      // Uptime of the last record returned
+  uint32_t value;     // Its value, 0 for types without one
+};
+
+EventPage eventPage;             // Page being filled
+uint32_t eventLastTime = 0;      // Uptime seconds of the newest record
+bool eventPageDirty = false;
+unsigned long eventFlushedAt = 0;
+bool eventLogReady = false;
+
+// A record on its way from the control side, which logs every event, to
+// taskEventLog(), which packs it into eventPage. The channel snapshot is
+// taken when the event happens.
+struct EventEntry {
+  uint32_t time;   // Uptime seconds
+  uint8_t type;    // As EventRecord.type
+  uint8_t bits;    // As EventRecord.bits
+  uint32_t value;  // For eventHasValue() types
+};
+
+SpscQueue<EventEntry, EVENT_QUEUE_SIZE> eventQueue;
+uint32_t eventsDropped = 0;  // Events lost to a full queue
+
+// Runtime statistics, all constant-memory and updated on pump transitions.
+// Fill time is the time from pump ON to FULL; its mean and variance use
+// Welford's update so no history is kept.
+struct RunStats {
+  uint32_t fills;               // Completed fills (FILLING -> FULL)
+  float fillMean;               // Seconds
+  float fillM2;                 // Sum of squared deviations, for the variance
+  uint32_t runSeconds;          // Total pump ON time of finished runs
+  unsigned long pumpStartedAt;  // millis() the current run started
+  unsigned long lastFullAt;     // millis() of the last FULL, valid once fills > 0
+  uint8_t starts[STATS_BUCKETS];  // Pump starts per bucket, newest in startsBucket
+  uint8_t startsBucket;
+  unsigned long bucketStartedAt;
+  bool longFill;                // Current (or last) fill was anomalously long
+};
+
+RunStats stats = {};
+bool statsChanged = true;  // Publish the stats frame on the next telemetry tick
+bool metricsDue = false;   // Publish the metrics frame on the next telemetry tick
+
+uint32_t telemetryVersion = 0;        // statusVersion of the last published state frame
+uint32_t pushVersion = 0;             // statusVersion of the last frame pushed to /ws
+bool telemetryHeartbeatDue = true;    // Publish the health frame on the next telemetry tick
+unsigned long telemetryHeartbeatAt = 0;
+
+// Level sensor drivers. Floats use the timer sampler below; continuous
+// sensors take a raw reading every `period` ms, which goes through a median
+// filter and a moving average, is calibrated to a percentage, and is then
+// compared against the configured start/stop levels to produce virtual
+// low/high floats. The pump state machine only ever sees those two floats.
+enum LevelSensorType : uint8_t { LEVEL_SENSOR_FLOATS, LEVEL_SENSOR_ADC, LEVEL_SENSOR_ULTRASONIC };
+
+struct LevelDriver {
+  const char *name;
+  void (*begin)();
+  void (*end)();                // Releases the pins before another driver starts
+  bool (*read)(uint16_t &raw);  // False if there is no valid reading this time
+  unsigned long period;
+};
+
+void beginAdcSensor();
+bool readAdcSensor(uint16_t &raw);
+void beginUltrasonicSensor();
+void endUltrasonicSensor();
+bool readUltrasonicSensor(uint16_t &raw);
+
+const LevelDriver LEVEL_DRIVERS[] = {
+  { "floats",     nullptr,               nullptr,             nullptr,              0 },
+  { "adc",        beginAdcSensor,        nullptr,             readAdcSensor,        100 },
+  { "ultrasonic", beginUltrasonicSensor, endUltrasonicSensor, readUltrasonicSensor, 100 },
+};
+const size_t LEVEL_DRIVER_COUNT = sizeof(LEVEL_DRIVERS) / sizeof(LEVEL_DRIVERS[0]);
+
+struct LevelFilter {
+  uint16_t raw[LEVEL_MEDIAN_SIZE];
+  uint8_t count;
+  uint8_t next;
+  float average;   // Moving average of the medians, raw units
+  uint8_t misses;  // Consecutive failed or out-of-range readings
+  bool low;        // Virtual floats, with LEVEL_HYSTERESIS applied
+  bool high;
+  unsigned long sampledAt;
+};
+
+LevelFilter levelFilter = {};
+uint8_t levelSensorRunning = LEVEL_SENSOR_FLOATS;  // Driver started by beginLevelSensor()
+
+volatile unsigned long echoStartedAt = 0;  // Written by onEchoChange()
+volatile unsigned long echoWidth = 0;
+volatile bool echoReady = false;
+
+volatile uint32_t flowPulses = 0;  // Written by onFlowPulse(), wraps
+FlowMeter flow = {};               // Main tank's pump
+uint32_t flowLastFillMl = 0;       // Volume of the last finished pump run
+uint32_t flowReportedRate = 0;     // mL/min in the last status frame
+
+// Tank channels. A channel is one tank: its float switches, the pump that
+// fills it, and that pump's state machine and override. Its commands and
+// state frame live under mqttBase "<id>/". A pump can draw from
+// another channel's tank (`source`); it is interlocked off while that tank
+// is below its low float, so it never runs dry. Channel 0 is the main tank:
+// only it can use a continuous level sensor, and the run statistics follow
+// its pump. Schedule windows apply to every channel.
+#define NO_SOURCE -1
+
+struct Channel {
+  const char *id;
+  uint8_t lowPin;
+  uint8_t highPin;
+  uint8_t relayPin;
+  int8_t source;            // Channel whose tank feeds this pump, or NO_SOURCE
+  SensorFilter filters[2];  // Low and high float, see src/sensor_filter.h
+  PumpControl pump;         // See src/pump_control.h
+  bool low;                 // Low float WET, or level above the start threshold
+  bool high;                // High float WET, or level at the stop threshold
+  bool fault;               // Continuous sensor has no trustworthy reading
+  uint8_t level;            // Last reported level (floats report 0/50/100)
+  bool overrideMode;
+  bool overrideState;
+  bool eventPending;        // Set on sensor edges, override commands and schedule windows
+};
+
+Channel channels[] = {
+  { "main", BOARD.lowSensorPin, BOARD.highSensorPin, BOARD.relayPin, NO_SOURCE },
+#if TANK_CHANNELS > 1
+  { "roof", BOARD.roofLowSensorPin, BOARD.roofHighSensorPin, BOARD.roofRelayPin, 0 },  // Transfer pump from the main tank
+#endif
+};
+const size_t CHANNEL_COUNT = sizeof(channels) / sizeof(channels[0]);
+static_assert(CHANNEL_COUNT == TANK_CHANNELS, "TANK_CHANNELS has no pin assignment");
+static_assert(CHANNEL_COUNT == 1 || BOARD.roofRelayPin != BOARD_NO_PIN, "This board has no second channel wired");
+static_assert(CHANNEL_COUNT <= 16, "The event log has four bits for the channel");
+
+Channel &mainTank = channels[0];
+
+// Commands from the networking side (MQTT handlers, taskWeb()) to the
+// control side, applied by handlePumpLogic() before it runs the pumps. The
+// networking side never writes a channel, the flow meter or the level
+// filter itself. The last three also refresh controlSettings.
+enum ControlCommandType : uint8_t {
+  CONTROL_OVERRIDE,          // arg is an OverrideAction
+  CONTROL_FLOW_RESET,        // Clear a latched no-flow fault
+  CONTROL_SENSOR_RESTART,    // Level sensor settings changed
+  CONTROL_FLOW_RESTART,      // Flow meter calibration changed
+  CONTROL_SCHEDULE_CHANGED,  // Schedule rules changed
+};
+enum OverrideAction : uint8_t { OVERRIDE_AUTO, OVERRIDE_OFF, OVERRIDE_ON };
+
+struct ControlCommand {
+  ControlCommandType type;
+  uint8_t channel;
+  uint8_t arg;
+};
+
+SpscQueue<ControlCommand, CONTROL_QUEUE_SIZE> controlQueue;
+
+// Room for the status frame: the main tank's fields plus a short entry per
+// other channel.
+const size_t STATUS_JSON_MAX = 300 + 96 * (CHANNEL_COUNT - 1);
+
+// Window in force, from the local time and the schedule rules. NONE until NTP
+// has set the clock, so an unsynced unit runs on the floats alone.
+ScheduleAction scheduleAction = SCHEDULE_NONE;
+bool clockSet = false;
+
+// Bumped on every change to anything reported by /api/status. Used as the
+// ETag so a client polling unchanged state gets an empty 304.
+uint32_t statusVersion = 1;
+// Drawn at boot and sent with the version, which restarts at 1, so a token
+// a client kept from before a reboot never matches the new state.
+uint32_t bootNonce = 0;
+
+// MQTT topic namespaces, built from the config by buildMqttTopics()
+char deviceId[16];                    // "wt-" and the chip ID; also the MQTT client ID
+char mqttBase[MQTT_TOPIC_MAX];        // "<prefix>/<device id>/"
+char mqttGroupBase[MQTT_TOPIC_MAX];   // "<prefix>/group/<group>/", empty without a group
+char mqttBroadcastBase[MQTT_TOPIC_MAX];
+const char *const MQTT_COMMAND_BASES[] = { mqttBase, mqttGroupBase, mqttBroadcastBase };
+
+// MQTT command routes under each of MQTT_COMMAND_BASES, see
+// src/mqtt_commands.h. To add a command, write a handler and add a line to
+// MQTT_ROUTES, or to CHANNEL_ROUTES for one that acts on a tank; those are
+// routed under "<base><id>/" with commandChannel pointing at the tank.
+// An override outside any channel namespace acts on the main tank.
+bool onOverrideCommand(const byte *payload, unsigned int length);
+bool onOtaCommand(const byte *payload, unsigned int length);
+bool onScheduleCommand(const byte *payload, unsigned int length);
+bool onFlowResetCommand(const byte *payload, unsigned int length);
+
+constexpr MqttRoute MQTT_ROUTES[] = {
+  MQTT_ROUTE("override", onOverrideCommand),
+  MQTT_ROUTE("ota", onOtaCommand),
+  MQTT_ROUTE("schedule", onScheduleCommand),
+  MQTT_ROUTE("flow/reset", onFlowResetCommand),
+};
+const size_t MQTT_ROUTE_COUNT = sizeof(MQTT_ROUTES) / sizeof(MQTT_ROUTES[0]);
+
+constexpr MqttRoute CHANNEL_ROUTES[] = {
+  MQTT_ROUTE("override", onOverrideCommand),
+};
+const size_t CHANNEL_ROUTE_COUNT = sizeof(CHANNEL_ROUTES) / sizeof(CHANNEL_ROUTES[0]);
+
+Channel *commandChannel = &channels[0];  // Tank the command being dispatched is for
+
+// Cooperative scheduler
+// Every subsystem is a task with its own period. A period of 0 means the task
+// is serviced on every pass through loop(). The deadline is how late a task
+// may start before it is counted as an overrun. The group says which side
+// runs it on the ESP32: control tasks only touch the sensors, pumps and
+// statistics and never block; everything that talks to the network, the
+// flash or the web server is a network task.
+enum TaskGroup : uint8_t { TASK_CONTROL = 0x01, TASK_NETWORK = 0x02 };
+
+struct Task {
+  const char *name;
+  void (*run)();
+  unsigned long period;    // ms between runs, 0 = every pass
+  unsigned long deadline;  // ms of allowed start latency
+  uint8_t group;           // TaskGroup
+  unsigned long lastRun;
+  unsigned long overruns;
+  // Run time in CPU cycles, for /metrics
+  uint32_t runs;
+  uint32_t minCycles;
+  uint32_t maxCycles;
+  uint32_t avgCycles;      // EWMA, each run weighted 1/8
+};
+
+// Loop pass interval histogram, upper bounds in microseconds. Passes slower
+// than the last bound land in the overflow bucket.
+const uint32_t LOOP_BUCKETS_US[] = { 1000, 2000, 5000, 10000, 20000, 50000, 100000, 500000 };
+const size_t LOOP_BUCKET_COUNT = sizeof(LOOP_BUCKETS_US) / sizeof(LOOP_BUCKETS_US[0]);
+uint32_t loopHistogram[LOOP_BUCKET_COUNT + 1];
+uint32_t loopMaxUs = 0;
+uint64_t loopTotalUs = 0;
+uint32_t loopPasses = 0;
+
+uint32_t wifiReconnects = 0;
+uint32_t mqttConnects = 0;
+uint32_t mqttConnectFailures = 0;
+
+#if SOAK_TEST
+// Worst values seen in one SOAK_WINDOW_MS window. Heap is checked by
+// taskSoak() every pass, the loop interval by recordLoopInterval().
+struct SoakSample {
+  uint32_t uptime;          // s, at the end of the window
+  uint32_t heapMin;         // Lowest free heap, bytes
+  uint32_t blockMin;        // Smallest largest-free-block, bytes
+  uint32_t loopMaxUs;       // Slowest loop pass
+  uint16_t wifiReconnects;  // Running totals at the end of the window
+  uint16_t mqttConnects;
+  uint16_t mqttFailures;
+  uint8_t fragMax;          // Worst heap fragmentation, %
+  uint8_t reserved;
+};
+
+SoakSample soakSamples[SOAK_SAMPLES];
+uint32_t soakCount = 0;  // Windows ever completed; the ring keeps the last SOAK_SAMPLES
+SoakSample soakWindow;
+unsigned long soakWindowStart = 0;
+#endif
+uint32_t mqttConnectMs = 0;  // Longest the last connect attempt blocked the loop in one step
+
+void taskSampleSensors();
+void handlePumpLogic();
+void taskWiFi();
+void taskMQTT();
+void taskWeb();
+void handleLED();
+void taskTelemetry();
+void taskPush();
+void taskLog();
+void taskEventLog();
+void taskStats();
+void taskOta();
+#if !defined(ESP32)
+void taskPower();
+#endif
+void taskSchedule();
+void taskFlow();
+#if SOAK_TEST
+void taskSoak();
+#endif
+
+Task tasks[] = {
+  // name       run                period deadline group
+  { "sensors",   taskSampleSensors,   50,   50, TASK_CONTROL },
+  { "pump",      handlePumpLogic,     50,   50, TASK_CONTROL },
+  { "wifi",      taskWiFi,           100,  100, TASK_NETWORK },
+  { "mqtt",      taskMQTT,             0,   50, TASK_NETWORK },
+  { "web",       taskWeb,              0,   50, TASK_NETWORK },
+  { "led",       handleLED,           50,   50, TASK_NETWORK },
+  { "log",       taskLog,              0,   50, TASK_NETWORK },
+  { "events",    taskEventLog,      1000, 1000, TASK_NETWORK },
+  { "stats",     taskStats,         1000, 1000, TASK_CONTROL },
+  { "telemetry", taskTelemetry,      250,  250, TASK_NETWORK },
+  { "push",      taskPush,           100,  100, TASK_NETWORK },
+  { "ota",       taskOta,              0,   50, TASK_NETWORK },
+#if !defined(ESP32)
+  { "power",     taskPower,          100,  100, TASK_NETWORK },
+#endif
+  { "schedule",  taskSchedule,       1000, 1000, TASK_CONTROL },
+  { "flow",      taskFlow,            250,  250, TASK_CONTROL },
+#if SOAK_TEST
+  { "soak",      taskSoak,            100,  100, TASK_NETWORK },
+#endif
+};
+const size_t TASK_COUNT = sizeof(tasks) / sizeof(tasks[0]);
 
 void setup() {
+#if defined(ESP32)
   Serial.begin(115200);
+  configLock = xSemaphoreCreateMutex();
+#else
+  Serial.begin(115200, SERIAL_8N1, SERIAL_TX_ONLY);  // RX is the flow meter input
+#endif
+  bootNonce = hardwareRandom();
   
-  pinMode(RELAY_PIN, OUTPUT);
-  digitalWrite(RELAY_PIN, LOW);
-
-  pinMode(LOW_SENSOR_PIN, INPUT);
-  pinMode(HIGH_SENSOR_PIN, INPUT);
+  for (Channel &ch : channels) {
+    pumpControlBegin(ch.pump, ch.relayPin, BOARD.relayActiveHigh, PUMP_MIN_RUN_MS, PUMP_MIN_REST_MS);
+    pinMode(ch.relayPin, OUTPUT);  // After the OFF level is latched, so an active-low relay never clicks on
+    ch.filters[0].pin = ch.lowPin;
+    ch.filters[1].pin = ch.highPin;
+    ch.eventPending = true;
+    pinMode(ch.lowPin, INPUT);
+    pinMode(ch.highPin, INPUT);
+  }
+  startSensorSampler();
   
-  pinMode(LED_PIN, OUTPUT);
-  digitalWrite(LED_PIN, HIGH);
+  setLed(false);
+  pinMode(BOARD.ledPin, OUTPUT);
   
   loadConfig();
+  checkLevelSensorSetting(config);
+  copyControlSettings();
+  beginLevelSensor();
+  beginFlowMeter();
+  beginEventLog();
+  beginOta();
+  beginClock();
   
-  WiFi.begin(wifi_ssid, wifi_password);
-  unsigned long startAttemptTime = millis();
-  while (WiFi.status() != WL_CONNECTED && millis() - startAttemptTime < 15000) {
-    delay(500);
-    Serial.print(".");
-  }
-
-  if (WiFi.status() != WL_CONNECTED) {
-    WiFi.softAP("WaterTank-Setup");
-    apMode = true;
-    Serial.println("AP Mode Started");
-  } else {
-    digitalWrite(LED_PIN, LOW);
-  }
+  startWiFi();
+  applyPowerMode();
   
-  if (mqttConfigured) {
-    client.setServer(mqtt_server, mqtt_port);
-    client.setCallback(mqttCallback);
-  }
+#if defined(ESP32)
+  espClient.setTimeout((MQTT_CONNECT_TIMEOUT_MS + 999) / 1000);  // Seconds on the ESP32
+  tlsClient.setTimeout((MQTT_TLS_TIMEOUT_MS + 999) / 1000);
+  tlsClient.setHandshakeTimeout((MQTT_TLS_TIMEOUT_MS + 999) / 1000);
+#else
+  espClient.setTimeout(MQTT_CONNECT_TIMEOUT_MS);
+  tlsClient.setTimeout(MQTT_TLS_TIMEOUT_MS);
+  tlsClient.setSession(&tlsSession);
+#endif
+  client.setSocketTimeout(MQTT_SOCKET_TIMEOUT_S);
+  client.setCallback(mqttCallback);
+  client.setBufferSize(MQTT_BUFFER_SIZE);
+  applyMqttConfig();
   
   setupWebServer();
   server.begin();
+#if defined(ESP32)
+  xTaskCreatePinnedToCore(controlTask, "control", CONTROL_TASK_STACK, nullptr, CONTROL_TASK_PRIORITY, nullptr, CONTROL_CORE);
+  xTaskCreatePinnedToCore(networkTask, "network", NETWORK_TASK_STACK, nullptr, NETWORK_TASK_PRIORITY, nullptr, NETWORK_CORE);
+#endif
 }
 
 void loop() {
-  if (!apMode && mqttConfigured && !client.connected() && !mqttSkipped) {
-    reconnectMQTT();
+#if defined(ESP32)
+  vTaskDelete(nullptr);  // Everything runs in controlTask() and networkTask()
+#else
+  recordLoopPass();
+  runScheduler(TASK_CONTROL | TASK_NETWORK);
+  if (config.power_mode == POWER_ALWAYS_ON) {
+    yield();  // Let the WiFi stack run between passes
+  } else {
+    idleUntilNextTask();
   }
-  client.loop();
-  server.handleClient();
-  handleLED();
-  handlePumpLogic();
-  Serial.print("Pump State : ");
-  Serial.println(String(digitalRead(RELAY_PIN) == HIGH ? "ON" : "OFF"));
-  delay(1000);
+#endif
 }
 
-void setupWebServer() {
-  server.on("/", HTTP_GET, []() {
-    String html = "<html><body>"
-                  "<script>"
-                  "function fetchStatus() {"
-                  "fetch('/')"
-                  ".then(response => response.text())"
-                  ".then(html => { document.body.innerHTML = html; });"
-                  "}"
-                  "setInterval(fetchStatus, 2000);"
-                  "</script>"
-                  "<h3>Controller Status</h3>"
-                  "<table border='1'><tr><th>Item</th><th>Status</th></tr>"
-                  "<tr><td>WiFi Connected</td><td>" + String(WiFi.status() == WL_CONNECTED ? "Yes" : "No") + "</td></tr>"
-                  "<tr><td>MQTT Connected</td><td>" + String(client.connected() ? "Yes" : "No") + "</td></tr>"
-                  "<tr><td>Low Sensor</td><td>" + String(digitalRead(LOW_SENSOR_PIN) == HIGH ? "Active" : "Inactive") + "</td></tr>"
-                  "<tr><td>High Sensor</td><td>" + String(digitalRead(HIGH_SENSOR_PIN) == HIGH ? "Active" : "Inactive") + "</td></tr>"
-                  "<tr><td>Pump Status</td><td>" + String(digitalRead(RELAY_PIN) == LOW ? "OFF" : "ON") + "</td></tr>"
-                  "</table></body></html>";
-    server.send(200, "text/html", html);
-  });
+#if defined(ESP32)
+// Control side. Nothing else on CONTROL_CORE outranks it, so it wakes on
+// time whatever the network side is doing; in between the core is idle.
+void controlTask(void *) {
+  for (;;) {
+    runScheduler(TASK_CONTROL);
+    vTaskDelay(max(pdMS_TO_TICKS(msUntilNextTask(TASK_CONTROL)), (TickType_t)1));
+  }
+}
 
-  server.on("/setup", HTTP_GET, []() {
-    String html = "<html><body>"
-                  "<h3>Configuration Setup</h3><form action='/save' method='post'>"
-                  "<table border='1'><tr><th>Setting</th><th>Value</th></tr>"
-                  "<tr><td>SSID</td><td><input type='text' name='ssid' value='" + String(wifi_ssid) + "'></td></tr>"
-                  "<tr><td>Password</td><td><input type='password' name='wifipass' value='" + String(wifi_password) + "'></td></tr>"
-                  "<tr><td>MQTT Server</td><td><input type='text' name='server' value='" + String(mqtt_server) + "'></td></tr>"
-                  "<tr><td>MQTT Port</td><td><input type='number' name='port' value='" + String(mqtt_port) + "'></td></tr>"
-                  "<tr><td>Username</td><td><input type='text' name='user' value='" + String(mqtt_user) + "'></td></tr>"
-                  "<tr><td>Password</td><td><input type='password' name='pass' value='" + String(mqtt_password) + "'></td></tr>"
-                  "</table><input type='submit' value='Save'></form>"
-                   "</body></html>";
-    server.send(200, "text/html", html);
-  });
+// Network side: loop() without the control tasks. The loop metrics time its
+// passes; the control side shows up in its tasks' overruns.
+void networkTask(void *) {
+  for (;;) {
+    recordLoopPass();
+    runScheduler(TASK_NETWORK);
+    vTaskDelay(1);  // Let AsyncTCP and the idle task (task watchdog) run
+  }
+}
+#endif
 
-  server.on("/save", HTTP_POST, []() {
-    String newSSID = server.arg("ssid");
-    String newPass = server.arg("wifipass");
-    String newMQTT = server.arg("server");
-    String newUser = server.arg("user");
-    String newPassMQTT = server.arg("pass");
-    int newPort = server.arg("port").toInt();
-
-    if (newSSID.length() > 0) newSSID.toCharArray(wifi_ssid, sizeof(wifi_ssid));
-    if (newPass.length() > 0) newPass.toCharArray(wifi_password, sizeof(wifi_password));
-    if (newMQTT.length() > 0) newMQTT.toCharArray(mqtt_server, sizeof(mqtt_server));
-    if (newUser.length() > 0) newUser.toCharArray(mqtt_user, sizeof(mqtt_user));
-    if (newPassMQTT.length() > 0) newPassMQTT.toCharArray(mqtt_password, sizeof(mqtt_password));
-    if (newPort > 0) mqtt_port = newPort;
+void recordLoopPass() {
+  static uint32_t lastPassAt = micros();
+  uint32_t now = micros();
+  recordLoopInterval(now - lastPassAt);
+  lastPassAt = now;
+}
 
-    saveConfig();
+void recordLoopInterval(uint32_t us) {
+  size_t bucket = 0;
+  while (bucket < LOOP_BUCKET_COUNT && us > LOOP_BUCKETS_US[bucket]) {
+    bucket++;
+  }
+  loopHistogram[bucket]++;
+  loopMaxUs = max(loopMaxUs, us);
+  loopTotalUs += us;
+  loopPasses++;
+#if SOAK_TEST
+  soakWindow.loopMaxUs = max(soakWindow.loopMaxUs, us);
+#endif
+}
 
-    server.send(200, "text/html", "<html><body><h3>Settings Saved!</h3><a href='/'>Go Back</a></body></html>");
-    
-    delay(2000);
-    ESP.restart(); // Restart to apply new settings
-  });
+// Runs every due task in `groups` (TaskGroup bits), in table order.
+void runScheduler(uint8_t groups) {
+  for (size_t i = 0; i < TASK_COUNT; i++) {
+    Task &task = tasks[i];
+    if (!(task.group & groups)) {
+      continue;
+    }
+    unsigned long now = millis();
+    unsigned long elapsed = now - task.lastRun;
+    unsigned long period = taskPeriod(task);
+
+    if (period > 0 && elapsed < period) {
+      continue;
+    }
+    if (period > 0 && task.lastRun != 0 && elapsed - period > task.deadline) {
+      task.overruns++;
+    }
+
+    task.lastRun = now;
+    uint32_t startCycles = ESP.getCycleCount();
+    task.run();
+    uint32_t cycles = ESP.getCycleCount() - startCycles;
+
+    if (task.runs == 0) {
+      task.minCycles = cycles;
+      task.avgCycles = cycles;
+    }
+    task.runs++;
+    task.minCycles = min(task.minCycles, cycles);
+    task.maxCycles = max(task.maxCycles, cycles);
+    task.avgCycles = task.avgCycles - task.avgCycles / 8 + cycles / 8;
+  }
+}
+
+// In light sleep every periodic task runs at most once per latency interval.
+// Light sleep is ESP8266 only, so the ESP32's control core never gets to the
+// config read.
+unsigned long taskPeriod(const Task &task) {
+  if (powerSleeping && task.period > 0) {
+    return max(task.period, (unsigned long)config.power_latency_ms);
+  }
+  return task.period;
 }
 
-bool readSensor(int pin) {
-  int activeCount = 0;
-  for (int i = 0; i < 5; i++) {  // Read 5 times to filter noise
-    if (digitalRead(pin) == HIGH) { // HIGH means submerged (water detected)
-      activeCount++;
+// ms until the next periodic task in `groups` is due, at most
+// POWER_LATENCY_MAX_MS.
+unsigned long msUntilNextTask(uint8_t groups) {
+  unsigned long now = millis();
+  unsigned long idle = POWER_LATENCY_MAX_MS;
+  for (size_t i = 0; i < TASK_COUNT; i++) {
+    unsigned long period = taskPeriod(tasks[i]);
+    if (period > 0 && (tasks[i].group & groups)) {
+      unsigned long elapsed = now - tasks[i].lastRun;
+      idle = min(idle, elapsed >= period ? 0 : period - elapsed);
     }
-    delay(10);  // Short delay between readings
   }
-  return activeCount >= 3; // Return true if majority of readings are HIGH
+  return idle;
 }
 
-void handlePumpLogic() {
-  bool lowSensor = readSensor(LOW_SENSOR_PIN);  // HIGH = WET, LOW = DRY
-  bool highSensor = readSensor(HIGH_SENSOR_PIN);
-
-  Serial.print("Low Sensor: "); Serial.print(lowSensor ? "WET" : "DRY");
-  Serial.print(" | High Sensor: "); Serial.println(highSensor ? "WET" : "DRY");
-
-  if (!overrideMode) {
-    if (highSensor) {  
-      // 🛑 HIGH sensor detects water → Turn OFF the pump
-      digitalWrite(RELAY_PIN, LOW);
-      Serial.println("✅ High sensor WET, turning OFF pump.");
-    } 
-    else if (!lowSensor && !highSensor) {  
-      // 🚨 Both sensors are DRY (Tank empty) → Turn ON the pump
-      digitalWrite(RELAY_PIN, HIGH);
-      Serial.println("⚠️ Tank is EMPTY (both sensors dry), turning ON pump!");
-    } 
-    else {
-      // 🟢 If high sensor is DRY but low sensor is WET → Do nothing (keep current pump state)
-      Serial.println("🟡 High sensor dry, Low sensor wet → No change to pump.");
+#if !defined(ESP32)
+// Waits until the next periodic task is due, which lets the SDK sleep the
+// modem (and, in light sleep, the CPU). A float wake ends the wait early.
+// Tasks with no period are polled at the end of each wait; a download in
+// progress is not held up.
+void idleUntilNextTask() {
+  if (powerWakeRequested) {
+    powerWakeRequested = false;
+    powerAwakeUntil = millis() + POWER_SETTLE_MS;
+    if (powerSleeping) {
+      setPowerSleeping(false);
     }
-  } else {
-    // Manual Override Mode
-    digitalWrite(RELAY_PIN, overrideState ? LOW : HIGH);
   }
+  if (otaState != OTA_IDLE) {
+    yield();
+    return;
+  }
+
+  unsigned long now = millis();
+  unsigned long idle = msUntilNextTask(TASK_CONTROL | TASK_NETWORK);
+  if (idle == 0) {
+    yield();
+    return;
+  }
+
+  esp_delay(idle, []() { return !powerWakeRequested; });
+  powerIdleMs += millis() - now;
 }
+#endif
 
-void handleLED() {
-  if (WiFi.status() == WL_CONNECTED) {
-    digitalWrite(LED_PIN, LOW);  // LED ON (assuming active low)
+// Applies the configured power policy: radio sleep type, listen interval
+// and the MQTT keepalive. A changed keepalive takes effect on the next
+// connect.
+void applyPowerMode() {
+  if (config.power_mode > POWER_LIGHT_SLEEP) {
+    config.power_mode = POWER_ALWAYS_ON;
+  }
+  config.power_latency_ms = constrain(config.power_latency_ms, POWER_LATENCY_MIN_MS, POWER_LATENCY_MAX_MS);
+  client.setKeepAlive(mqttKeepAlive());
+  setPowerSleeping(false);
+  LOG_INFO("Power mode: %s, %u ms latency, %u s keepalive",
+           POWER_MODE_NAMES[config.power_mode], config.power_latency_ms, mqttKeepAlive());
+}
+
+// The MQTT client is only serviced once per latency interval while asleep.
+// A keepalive of at least three intervals gets the ping out and its answer
+// back well inside the broker's 1.5x grace, with a second chance in between.
+uint16_t mqttKeepAlive() {
+  if (config.power_mode == POWER_ALWAYS_ON) {
+    return MQTT_KEEPALIVE_S;
+  }
+  return max((unsigned)MQTT_KEEPALIVE_S, 3 * ((config.power_latency_ms + 999) / 1000u));
+}
+
+#if defined(ESP32)
+// The ESP32 port does not light sleep: in either power-saving mode the
+// radio sleeps between beacons and the tasks keep their periods.
+void setPowerSleeping(bool) {
+  WiFi.setSleep(config.power_mode != POWER_ALWAYS_ON);
+}
+#else
+// Light sleep is only worth it, and only safe, while nothing is going on:
+// no pump run, no pending pump decision or command, no update, nobody
+// watching the dashboard and the station link up (the setup AP cannot
+// sleep).
+void taskPower() {
+  bool busy = spscCount(controlQueue) > 0;
+  for (const Channel &ch : channels) {
+    busy = busy || ch.pump.on || ch.eventPending;
+  }
+  bool sleep = config.power_mode == POWER_LIGHT_SLEEP && !busy &&
+               otaState == OTA_IDLE && wifiState == WIFI_ONLINE && ws.count() == 0 &&
+               (long)(millis() - powerAwakeUntil) >= 0;
+  if (sleep != powerSleeping) {
+    setPowerSleeping(sleep);
+  }
+}
+
+void setPowerSleeping(bool sleeping) {
+  uint8_t listen = constrain(config.power_latency_ms / POWER_BEACON_MS, 1, POWER_LISTEN_MAX);
+
+  if (sleeping) {
+    // The 200 Hz sampler would wake the CPU every 5 ms. Stop it and have the
+    // SDK wake the CPU when a float moves away from its filtered level. The
+    // interrupt must use the same level: attachInterrupt() rewrites the
+    // pin's trigger, and an edge mode would undo the wakeup level.
+    timer1_disable();
+    for (size_t i = usesFloats(mainTank) ? 0 : 1; i < CHANNEL_COUNT; i++) {
+      for (const SensorFilter &f : channels[i].filters) {
+        gpio_pin_wakeup_enable(GPIO_ID_PIN(f.pin), f.state ? GPIO_PIN_INTR_LOLEVEL : GPIO_PIN_INTR_HILEVEL);
+        attachInterruptArg(digitalPinToInterrupt(f.pin), onFloatWake, (void *)(uintptr_t)f.pin,
+                           f.state ? ONLOW_WE : ONHIGH_WE);
+      }
+    }
+    WiFi.setSleepMode(WIFI_LIGHT_SLEEP, listen);
   } else {
-    static unsigned long lastBlinkTime = 0;
-    static bool ledState = false;
+    if (powerSleeping) {
+      gpio_pin_wakeup_disable();
+      for (const Channel &ch : channels) {
+        for (const SensorFilter &f : ch.filters) {
+          detachInterrupt(digitalPinToInterrupt(f.pin));
+        }
+      }
+      startSensorSampler();
+      // Make every task due now, without the sleep counting as an overrun
+      unsigned long now = millis();
+      for (size_t i = 0; i < TASK_COUNT; i++) {
+        tasks[i].lastRun = now - tasks[i].period;
+      }
+    }
+    WiFi.setSleepMode(config.power_mode == POWER_ALWAYS_ON ? WIFI_NONE_SLEEP : WIFI_MODEM_SLEEP, listen);
+  }
 
-    if (millis() - lastBlinkTime >= 500) {  // Blink every 500ms
-      lastBlinkTime = millis();
-      ledState = !ledState;
-      digitalWrite(LED_PIN, ledState ? HIGH : LOW);
+  if (sleeping != powerSleeping) {
+    LOG_DEBUG("Light sleep %s", sleeping ? "entered" : "left");
+  }
+  powerSleeping = sleeping;
+}
+
+// Float left its level while light sleeping. Ends the wait in
+// idleUntilNextTask(). The interrupt is level triggered and would fire
+// again on every return while the pin stays there, so it masks itself;
+// setPowerSleeping(false) detaches it.
+void IRAM_ATTR onFloatWake(void *pin) {
+  GPC((uintptr_t)pin) &= ~(0xF << GPCI);
+  powerWakeRequested = true;
+  esp_schedule();
+}
+
+// timer1 is stopped while light sleeping, so the filters hold the levels
+// from before the sleep. Each latency tick reads the pins directly instead;
+// a float that has moved wakes the unit and the sampler debounces it, which
+// also covers an edge the wake interrupt missed.
+void pollFloatsAsleep() {
+  for (size_t i = usesFloats(mainTank) ? 0 : 1; i < CHANNEL_COUNT; i++) {
+    for (const SensorFilter &f : channels[i].filters) {
+      if (halDigitalRead(f.pin) != f.state) {
+        powerWakeRequested = true;
+      }
     }
   }
 }
+#endif
 
-void mqttCallback(char* topic, byte* payload, unsigned int length) {
-  String message;
-  for (unsigned int i = 0; i < length; i++) {
-    message += (char)payload[i];
+void taskSampleSensors() {
+#if !defined(ESP32)
+  if (powerSleeping) {
+    pollFloatsAsleep();
   }
+#endif
+  for (size_t i = 0; i < CHANNEL_COUNT; i++) {
+    Channel &ch = channels[i];
+    if (usesFloats(ch)) {
+      bool low = sensorFilterRead(ch.filters, 2, ch.lowPin);  // HIGH = WET, LOW = DRY
+      bool high = sensorFilterRead(ch.filters, 2, ch.highPin);
+      updateChannelLevel(i, low, high, false, high ? 100 : low ? 50 : 0);
+      continue;
+    }
 
-  if (String(topic) == "waterpump/override") {
-    if (message == "ON") {
-      overrideMode = true;
-      overrideState = true;
-      digitalWrite(RELAY_PIN, LOW);
-    } else if (message == "OFF") {
-      overrideMode = true;
-      overrideState = false;
-      digitalWrite(RELAY_PIN, HIGH);
-    } else if (message == "AUTO") {
-      overrideMode = false;
+    const LevelDriver &driver = LEVEL_DRIVERS[controlSettings.sensorType];
+    if (millis() - levelFilter.sampledAt >= driver.period) {
+      levelFilter.sampledAt = millis();
+      uint16_t raw = 0;
+      updateLevelFilter(driver.read(raw), raw);
     }
+    updateChannelLevel(i, levelFilter.low, levelFilter.high, levelFilter.misses >= LEVEL_MAX_MISSES, levelFilterPercent());
   }
 }
 
-void reconnectMQTT() {
- int attempt = 0;
-  while (!client.connected() && mqttConfigured && !mqttSkipped && attempt < 2) {
-    Serial.print("Attempting MQTT connection... (Attempt ");
-    Serial.print(attempt + 1);
-    Serial.println("/2)");
-
-    if (client.connect("ESP8266Client", mqtt_user, mqtt_password)) {
-      Serial.println("✅ MQTT Connected!");
-      client.subscribe("waterpump/override");
-      return;  // Exit function if connected
+// The main tank may use a continuous sensor; every other channel has floats.
+bool usesFloats(const Channel &ch) {
+  return &ch != &mainTank || controlSettings.sensorType == LEVEL_SENSOR_FLOATS;
+}
+
+// Records a channel's latest reading. An edge asks the channel's pump, and
+// any pump drawing from this tank, to reconsider.
+void updateChannelLevel(size_t index, bool low, bool high, bool fault, uint8_t percent) {
+  Channel &ch = channels[index];
+  if (abs((int)percent - (int)ch.level) >= LEVEL_REPORT_STEP || (percent != ch.level && (percent == 0 || percent == 100))) {
+    ch.level = percent;
+    markStatusChanged();
+  }
+
+  if (low == ch.low && high == ch.high && fault == ch.fault) {
+    return;
+  }
+
+  if (fault != ch.fault) {
+    if (fault) {
+      LOG_ERROR("Level sensor (%s) has no valid reading", LEVEL_DRIVERS[controlSettings.sensorType].name);
     } else {
-      Serial.print("❌ Failed, rc=");
-      Serial.print(client.state());
-      Serial.println(" -> Retrying in 2 seconds...");
-      delay(2000);
-      attempt++;
+      LOG_INFO("Level sensor (%s) reading again", LEVEL_DRIVERS[controlSettings.sensorType].name);
+    }
+  }
+
+  ch.low = low;
+  ch.high = high;
+  ch.fault = fault;
+  ch.eventPending = true;
+  for (Channel &other : channels) {
+    if (other.source == (int8_t)index) {
+      other.eventPending = true;
     }
   }
+  markStatusChanged();
+  logEvent(EVENT_SENSORS, index);
+
+  LOG_INFO("%s: Low Sensor: %s | High Sensor: %s", ch.id, ch.low ? "WET" : "DRY", ch.high ? "WET" : "DRY");
+}
 
-  if (attempt == 2) {
-    mqttSkipped = true;
-    Serial.println("⚠️ MQTT connection failed after 2 attempts, skipping...");
+// Unknown types from a corrupt or newer config, and the ultrasonic sensor
+// when the board gives its pins to the second channel, fall back to the
+// floats. Network side: runs on every new config before the control side
+// copies it.
+void checkLevelSensorSetting(Config &settings) {
+  if (settings.sensor_type >= LEVEL_DRIVER_COUNT) {
+    settings.sensor_type = LEVEL_SENSOR_FLOATS;
+  }
+  if (TANK_CHANNELS > 1 && boardUltrasonicShared(BOARD) && settings.sensor_type == LEVEL_SENSOR_ULTRASONIC) {
+    LOG_ERROR("Ultrasonic sensor pins are used by the second tank, using floats");
+    settings.sensor_type = LEVEL_SENSOR_FLOATS;
   }
- 
 }
 
-void loadConfig() {
-  EEPROM.begin(EEPROM_SIZE);
+// Stops the driver that was running, then resets the filter and starts the
+// configured driver for the main tank.
+void beginLevelSensor() {
+  const LevelDriver &running = LEVEL_DRIVERS[levelSensorRunning];
+  if (running.end) {
+    running.end();
+  }
+  levelSensorRunning = controlSettings.sensorType;
 
-  EEPROM.get(WIFI_SSID_ADDR, wifi_ssid);
-  EEPROM.get(WIFI_PASS_ADDR, wifi_password);
-  EEPROM.get(MQTT_ADDR, mqtt_server);
-  EEPROM.get(MQTT_ADDR + 40, mqtt_user);
-  EEPROM.get(MQTT_ADDR + 60, mqtt_password);
-  EEPROM.get(MQTT_ADDR + 80, mqtt_port);
+  levelFilter = LevelFilter();
+  levelFilter.misses = LEVEL_MAX_MISSES;  // Faulted until the first good reading
+  mainTank.fault = controlSettings.sensorType != LEVEL_SENSOR_FLOATS;
 
-  wifi_ssid[sizeof(wifi_ssid) - 1] = '\0';
-  wifi_password[sizeof(wifi_password) - 1] = '\0';
-  mqtt_server[sizeof(mqtt_server) - 1] = '\0';
-  mqtt_user[sizeof(mqtt_user) - 1] = '\0';
-  mqtt_password[sizeof(mqtt_password) - 1] = '\0';
+  const LevelDriver &driver = LEVEL_DRIVERS[controlSettings.sensorType];
+  if (driver.begin) {
+    driver.begin();
+  }
+  LOG_INFO("Level sensor: %s", driver.name);
+}
 
-  if (strlen(mqtt_server) > 0) {
-    mqttConfigured = true;
+// Median of the last LEVEL_MEDIAN_SIZE raw readings feeds an exponential
+// moving average, which is then checked against the calibrated range.
+void updateLevelFilter(bool ok, uint16_t raw) {
+  if (!ok) {
+    if (levelFilter.misses < UINT8_MAX) {
+      levelFilter.misses++;
+    }
+    return;
   }
 
-  EEPROM.end();
+  levelFilter.raw[levelFilter.next] = raw;
+  levelFilter.next = (levelFilter.next + 1) % LEVEL_MEDIAN_SIZE;
+  if (levelFilter.count < LEVEL_MEDIAN_SIZE) {
+    levelFilter.count++;
+  }
+
+  uint16_t sorted[LEVEL_MEDIAN_SIZE];
+  memcpy(sorted, levelFilter.raw, levelFilter.count * sizeof(uint16_t));
+  for (uint8_t i = 1; i < levelFilter.count; i++) {
+    for (uint8_t j = i; j > 0 && sorted[j - 1] > sorted[j]; j--) {
+      uint16_t t = sorted[j];
+      sorted[j] = sorted[j - 1];
+      sorted[j - 1] = t;
+    }
+  }
+  float median = sorted[levelFilter.count / 2];
+
+  levelFilter.average = levelFilter.count == 1 ? median
+                        : levelFilter.average + LEVEL_EMA_WEIGHT * (median - levelFilter.average);
+
+  float percent = levelFilterRawPercent();
+  if (percent < -LEVEL_RANGE_MARGIN || percent > 100 + LEVEL_RANGE_MARGIN) {
+    levelFilter.misses = min(levelFilter.misses + 1, (int)UINT8_MAX);  // Open circuit or bad calibration
+    return;
+  }
+  levelFilter.misses = 0;
+
+  if (!levelFilter.low && percent > controlSettings.levelStart + LEVEL_HYSTERESIS) {
+    levelFilter.low = true;
+  } else if (levelFilter.low && percent <= controlSettings.levelStart - LEVEL_HYSTERESIS) {
+    levelFilter.low = false;
+  }
+  if (!levelFilter.high && percent >= controlSettings.levelStop + LEVEL_HYSTERESIS) {
+    levelFilter.high = true;
+  } else if (levelFilter.high && percent < controlSettings.levelStop - LEVEL_HYSTERESIS) {
+    levelFilter.high = false;
+  }
 }
 
-void saveConfig() {
-  EEPROM.begin(EEPROM_SIZE);
-  
-  EEPROM.put(WIFI_SSID_ADDR, wifi_ssid);
-  EEPROM.put(WIFI_PASS_ADDR, wifi_password);
-  EEPROM.put(MQTT_ADDR, mqtt_server);
-  EEPROM.put(MQTT_ADDR + 40, mqtt_user);
-  EEPROM.put(MQTT_ADDR + 60, mqtt_password);
-  EEPROM.put(MQTT_ADDR + 80, mqtt_port);
-
-  EEPROM.commit();
-  EEPROM.end();
+// Calibrated level, unclamped. Works for sensors whose raw value falls as the
+// tank fills (distance sensors) as well as ones where it rises.
+float levelFilterRawPercent() {
+  float span = (float)controlSettings.calFull - (float)controlSettings.calEmpty;
+  if (span == 0) {
+    return 0;
+  }
+  return (levelFilter.average - controlSettings.calEmpty) * 100.0f / span;
+}
+
+uint8_t levelFilterPercent() {
+  return (uint8_t)constrain(levelFilterRawPercent() + 0.5f, 0.0f, 100.0f);
+}
+
+void beginAdcSensor() {
+  pinMode(LEVEL_ADC_PIN, INPUT);
+}
+
+bool readAdcSensor(uint16_t &raw) {
+  raw = analogRead(LEVEL_ADC_PIN);
+  return true;
+}
+
+// Echo pin ISR for the ultrasonic sensor: the echo pulse width is the round
+// trip time, so no CPU time is spent waiting on pulseIn().
+void IRAM_ATTR onEchoChange() {
+  if (halDigitalRead(BOARD.ultrasonicEchoPin)) {
+    echoStartedAt = micros();
+  } else {
+    echoWidth = micros() - echoStartedAt;
+    echoReady = true;
+  }
+}
+
+void beginUltrasonicSensor() {
+  pinMode(BOARD.ultrasonicTrigPin, OUTPUT);
+  halDigitalWrite(BOARD.ultrasonicTrigPin, false);
+  pinMode(BOARD.ultrasonicEchoPin, INPUT);
+  attachInterrupt(digitalPinToInterrupt(BOARD.ultrasonicEchoPin), onEchoChange, CHANGE);
+}
+
+// Stops the echo ISR and stops driving trig, so no stale pulse is counted
+// and the pins are left as plain inputs.
+void endUltrasonicSensor() {
+  detachInterrupt(digitalPinToInterrupt(BOARD.ultrasonicEchoPin));
+  pinMode(BOARD.ultrasonicTrigPin, INPUT);
+  pinMode(BOARD.ultrasonicEchoPin, INPUT);
+  echoReady = false;
+}
+
+// Collects the echo of the previous ping, in mm, then fires the next one.
+bool readUltrasonicSensor(uint16_t &raw) {
+  bool ok = echoReady;
+  if (ok) {
+    unsigned long mm = echoWidth * 343UL / 2000UL;  // Speed of sound, there and back
+    ok = mm >= 20 && mm <= 6000;
+    raw = mm;
+  }
+
+  echoReady = false;
+  halDigitalWrite(BOARD.ultrasonicTrigPin, true);
+  delayMicroseconds(10);
+  halDigitalWrite(BOARD.ultrasonicTrigPin, false);
+  return ok;
+}
+
+// Flow meter ISR: one pulse per falling edge. Only the ISR writes the
+// counter and a 32-bit read is atomic, so taskFlow() needs no lock.
+void IRAM_ATTR onFlowPulse() {
+  flowPulses++;
+}
+
+// Resets the accounting and arms the pulse input, when a meter is fitted.
+void beginFlowMeter() {
+  detachInterrupt(digitalPinToInterrupt(BOARD.flowMeterPin));
+  flowMeterBegin(flow, controlSettings.flowPulsesPerLitre, FLOW_PRIME_MS, FLOW_NO_FLOW_MS, FLOW_RETRY_MS,
+                 flowPulses, millis());
+  flowReportedRate = 0;
+  if (controlSettings.flowPulsesPerLitre > 0) {
+    pinMode(BOARD.flowMeterPin, INPUT_PULLUP);  // Open-collector hall sensor
+    attachInterrupt(digitalPinToInterrupt(BOARD.flowMeterPin), onFlowPulse, FALLING);
+    LOG_INFO("Flow meter: %u pulses/L", controlSettings.flowPulsesPerLitre);
+  }
+}
+
+// Feeds the pulse count to the accounting. A no-flow fault stops the main
+// tank's pump through its FAULT state until the fault clears or is reset.
+void taskFlow() {
+  FlowTick tick = flowMeterTick(flow, flowPulses, millis(), mainTank.pump.on);
+  if (tick.faultRaised) {
+    LOG_ERROR("No flow from the pump, stopping it for %lu min", FLOW_RETRY_MS / 60000);
+    mainTank.eventPending = true;
+    markStatusChanged();
+    logEvent(EVENT_NO_FLOW, 0);
+  }
+  if (tick.faultCleared) {
+    LOG_INFO("Retrying the pump after a no-flow fault");
+    mainTank.eventPending = true;
+    markStatusChanged();
+  }
+  if (tick.cycleEnded) {
+    flowLastFillMl = tick.cycleMl;
+    LOG_INFO("Pump run moved %lu mL", (unsigned long)tick.cycleMl);
+    markStatusChanged();
+    logEventValue(EVENT_FILL_VOLUME, 0, tick.cycleMl);
+  }
+  uint32_t rate = flow.rateMlPerMin;
+  if ((rate > flowReportedRate ? rate - flowReportedRate : flowReportedRate - rate) >= FLOW_REPORT_STEP ||
+      (rate == 0) != (flowReportedRate == 0)) {
+    flowReportedRate = rate;
+    markStatusChanged();
+  }
+}
+
+// Flow fields for the main tank's status and state frames, with a leading
+// comma; empty without a meter.
+void formatFlowJson(char *json, size_t size) {
+  json[0] = '\0';
+  if (flow.pulsesPerLitre > 0) {
+    snprintf(json, size, ",\"flowLpm\":%.1f,\"lastFillL\":%.1f,\"noFlow\":%s",
+             flow.rateMlPerMin / 1000.0f, flowLastFillMl / 1000.0f, flow.fault ? "true" : "false");
+  }
+}
+
+// Starts joining the configured network without waiting for the result;
+// taskWiFi() follows the connection from the station events.
+void startWiFi() {
+  WiFi.persistent(false);  // Credentials live in our own config store
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(true);
+
+#if defined(ESP32)
+  WiFi.onEvent([](arduino_event_id_t) { wifiGotIPEvent = true; }, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  WiFi.onEvent([](arduino_event_id_t) { wifiDisconnectedEvent = true; }, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+#else
+  wifiGotIPHandler = WiFi.onStationModeGotIP([](const WiFiEventStationModeGotIP &) {
+    wifiGotIPEvent = true;
+  });
+  wifiDisconnectedHandler = WiFi.onStationModeDisconnected([](const WiFiEventStationModeDisconnected &) {
+    wifiDisconnectedEvent = true;
+  });
+#endif
+
+  File file = LittleFS.open(WIFI_CACHE_PATH, "r");
+  if (!file || file.read((uint8_t *)&wifiCache, sizeof(wifiCache)) != sizeof(wifiCache)) {
+    wifiCache = WifiCache();
+  }
+  file.close();
+
+  joinWiFi();
+}
+
+// (Re)joins the configured network. The setup AP, if open, stays up. With a
+// cache for these credentials the station goes straight to the cached AP and
+// channel with the cached address, instead of scanning and asking DHCP.
+void joinWiFi() {
+  if (!apMode) {
+    setWiFiState(WIFI_CONNECTING);
+  }
+  if (strlen(config.wifi_ssid) == 0) {
+    if (!apMode) {
+      startSetupAP();  // Nothing to join, go straight to setup
+    }
+    return;
+  }
+  uint32_t key = wifiCacheKey(config.wifi_ssid, config.wifi_password);
+  wifiFastJoin = wifiCacheUsable(wifiCache, key);
+  if (wifiFastJoin) {
+    wifiCacheCountJoin(wifiCache, key);
+    writeWifiCache();
+    WiFi.config(IPAddress(wifiCache.ip), IPAddress(wifiCache.gateway), IPAddress(wifiCache.subnet), IPAddress(wifiCache.dns));
+    WiFi.begin(config.wifi_ssid, config.wifi_password, wifiCache.channel, wifiCache.bssid);
+  } else {
+    WiFi.config(0U, 0U, 0U);  // Back to DHCP
+    WiFi.begin(config.wifi_ssid, config.wifi_password);
+  }
+}
+
+// Records the join the station just made. Only written when it differs, so
+// reconnects to the same AP cost no flash writes; joinWiFi() has already
+// stored the use a fast join makes of its lease.
+void saveWifiCache() {
+  WifiCache cache = {};
+  memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+  cache.channel = WiFi.channel();
+  cache.ip = WiFi.localIP();
+  cache.gateway = WiFi.gatewayIP();
+  cache.subnet = WiFi.subnetMask();
+  cache.dns = WiFi.dnsIP();
+  wifiCacheSealJoin(cache, wifiCache, wifiFastJoin, wifiCacheKey(config.wifi_ssid, config.wifi_password));
+  if (wifiCacheSame(cache, wifiCache)) {
+    return;
+  }
+  wifiCache = cache;
+  writeWifiCache();
+}
+
+void writeWifiCache() {
+  File file = LittleFS.open(WIFI_CACHE_PATH, "w");
+  if (!file || file.write((const uint8_t *)&wifiCache, sizeof(wifiCache)) != sizeof(wifiCache)) {
+    LOG_WARN("WiFi cache not saved");
+  }
+  file.close();
+}
+
+void taskWiFi() {
+  if (wifiGotIPEvent) {
+    wifiGotIPEvent = false;
+    if (apMode) {
+      captiveDns.stop();
+      WiFi.softAPdisconnect(true);
+      WiFi.mode(WIFI_STA);
+      apMode = false;
+      LOG_INFO("AP Mode Stopped");
+    }
+    static bool connectedBefore = false;
+    if (wifiState == WIFI_ONLINE) {
+      LOG_INFO("WiFi address renewed, IP: %s", WiFi.localIP().toString().c_str());
+    } else {
+      if (connectedBefore) {
+        wifiReconnects++;
+      }
+      LOG_INFO("WiFi connected in %lu ms%s, IP: %s", millis() - wifiStateSince, wifiFastJoin ? " (cached)" : "",
+               WiFi.localIP().toString().c_str());
+    }
+    connectedBefore = true;
+    setWiFiState(WIFI_ONLINE);
+    saveWifiCache();
+  }
+
+  if (wifiDisconnectedEvent) {
+    wifiDisconnectedEvent = false;
+    if (wifiState == WIFI_ONLINE) {
+      setWiFiState(WIFI_CONNECTING);  // The SDK keeps retrying on its own
+      LOG_WARN("WiFi connection lost");
+    }
+  }
+
+  if (wifiFastJoin && wifiState != WIFI_ONLINE && millis() - wifiStateSince >= WIFI_FAST_JOIN_MS) {
+    // The cached AP is gone, or moved channel or the lease: forget it and
+    // scan. A successful scan join writes a fresh cache.
+    LOG_WARN("Cached WiFi join failed, scanning");
+    wifiCache = WifiCache();
+    WiFi.disconnect();
+    joinWiFi();
+  }
+
+  if (wifiFastJoin && wifiState == WIFI_ONLINE && millis() - wifiStateSince >= WIFI_CACHE_RENEW_MS) {
+    // The cached lease may have run out by now. Ask DHCP without leaving
+    // the AP; the answer arrives as a new IP event and refreshes the cache.
+    LOG_INFO("Renewing the cached WiFi address over DHCP");
+    wifiFastJoin = false;
+    WiFi.config(0U, 0U, 0U);
+  }
+
+  if (wifiState == WIFI_CONNECTING && millis() - wifiStateSince >= WIFI_AP_FALLBACK_MS) {
+    startSetupAP();
+  }
+
+  if (apMode) {
+    captiveDns.processNextRequest();
+  }
+}
+
+// Opens the setup AP next to the station interface, which keeps retrying.
+// Every DNS name resolves to the AP, so a phone joining it gets its
+// captive-portal check redirected to the setup page.
+void startSetupAP() {
+  WiFi.mode(WIFI_AP_STA);
+  WiFi.softAP(WIFI_AP_SSID);
+  captiveDns.start(CAPTIVE_DNS_PORT, "*", WiFi.softAPIP());
+  apMode = true;
+  setWiFiState(WIFI_AP_FALLBACK);
+  LOG_WARN("AP Mode Started");
+}
+
+void setWiFiState(WifiState state) {
+  wifiState = state;
+  wifiStateSince = millis();
+  markStatusChanged();
+}
+
+void taskMQTT() {
+  if (!mqttConfigured || WiFi.status() != WL_CONNECTED) {
+    return;
+  }
+
+  if (client.connected()) {
+    client.loop();
+    return;
+  }
+
+  if (mqttWasConnected) {
+    // Connection just dropped: try again straight away, then back off
+    mqttWasConnected = false;
+    mqttBackoff = MQTT_BACKOFF_MIN_MS;
+    mqttNextAttempt = millis();
+    markStatusChanged();
+    LOG_WARN("MQTT connection lost");
+  }
+
+  if ((long)(millis() - mqttNextAttempt) >= 0) {
+    reconnectMQTT();
+  }
+}
+
+// Requests are served from the TCP stack's callbacks, not from here. This
+// does what those callbacks must not: settings posted to /save are written
+// to flash and the affected subsystems restarted from loop() context.
+void taskWeb() {
+  if (configSavePending) {
+    Config previous = config;
+    CONFIG_LOCK();
+    configSavePending = false;
+    config = pendingConfig;
+    checkLevelSensorSetting(config);
+    CONFIG_UNLOCK();
+    saveConfig();
+    applyConfigChanges(previous);
+  }
+  ws.cleanupClients(WS_MAX_CLIENTS);
+}
+
+// Publishes retained JSON frames under mqttBase:
+//   state   pump, state machine, sensors, override, and for the main tank
+//           the flow meter; sent only when the status
+//           version moved since the last frame. The task's 250 ms period
+//           batches changes that land close together into one frame.
+//   health  RSSI, free heap, uptime, firmware and board; sent every
+//           TELEMETRY_HEARTBEAT_MS
+void taskTelemetry() {
+  if (!client.connected()) {
+    return;
+  }
+
+  if (telemetryVersion != statusVersion) {
+    bool sent = true;
+    for (const Channel &ch : channels) {
+      char flowJson[64] = "";
+      if (&ch == &mainTank) {
+        formatFlowJson(flowJson, sizeof(flowJson));
+      }
+      char json[256];
+      snprintf(json, sizeof(json),
+               "{\"pump\":%s,\"state\":\"%s\",\"low\":%s,\"high\":%s,\"level\":%u,"
+               "\"sensorFault\":%s,\"override\":%s,\"window\":\"%s\"%s}",
+               ch.pump.on ? "true" : "false",
+               PUMP_STATE_NAMES[ch.pump.state],
+               ch.low ? "true" : "false",
+               ch.high ? "true" : "false",
+               ch.level,
+               ch.fault ? "true" : "false",
+               ch.overrideMode ? (ch.overrideState ? "\"ON\"" : "\"OFF\"") : "false",
+               SCHEDULE_ACTION_NAMES[scheduleAction], flowJson);
+      char suffix[MQTT_TOPIC_MAX];
+      snprintf(suffix, sizeof(suffix), "%s/state", ch.id);
+      sent = publishTelemetry(suffix, json) && sent;
+      if (&ch == &mainTank) {
+        sent = publishTelemetry("state", json) && sent;  // Pre-channel topic, for existing dashboards
+      }
+    }
+    if (sent) {
+      telemetryVersion = statusVersion;
+    }
+  }
+
+  if (telemetryHeartbeatDue || millis() - telemetryHeartbeatAt >= TELEMETRY_HEARTBEAT_MS) {
+    char json[128];
+    snprintf(json, sizeof(json), "{\"rssi\":%d,\"heap\":%lu,\"uptime\":%lu,\"fw\":\"%s\",\"board\":\"%s\"}",
+             (int)WiFi.RSSI(), (unsigned long)ESP.getFreeHeap(), millis() / 1000, FIRMWARE_VERSION, BOARD.name);
+    if (publishTelemetry("health", json)) {
+      telemetryHeartbeatDue = false;
+      telemetryHeartbeatAt = millis();
+      statsChanged = true;  // Stats and metrics ride along with the heartbeat
+      metricsDue = true;
+    }
+  }
+
+  if (metricsDue) {
+    char json[MQTT_BUFFER_SIZE - MQTT_TOPIC_MAX - 8];
+    formatMetricsJson(json, sizeof(json));
+    if (publishTelemetry("metrics", json)) {
+      metricsDue = false;
+    }
+  }
+
+  if (statsChanged) {
+    char json[224];
+    formatStatsJson(json, sizeof(json));
+    if (publishTelemetry("stats", json)) {
+      statsChanged = false;
+    }
+  }
+}
+
+void statsPumpStarted() {
+  stats.pumpStartedAt = millis();
+  if (stats.starts[stats.startsBucket] < UINT8_MAX) {
+    stats.starts[stats.startsBucket]++;
+  }
+  stats.longFill = false;
+}
+
+void statsPumpStopped() {
+  stats.runSeconds += (millis() - stats.pumpStartedAt) / 1000;
+  statsChanged = true;
+}
+
+void statsFillCompleted() {
+  float seconds = (millis() - stats.pumpStartedAt) / 1000.0f;
+  stats.fills++;
+  float delta = seconds - stats.fillMean;
+  stats.fillMean += delta / stats.fills;
+  stats.fillM2 += delta * (seconds - stats.fillMean);
+  stats.lastFullAt = millis();
+  statsChanged = true;
+}
+
+float statsFillStddev() {
+  return stats.fills > 1 ? sqrtf(stats.fillM2 / (stats.fills - 1)) : 0.0f;
+}
+
+// Rotates the cycles/hour buckets and watches the running fill: once the
+// mean is established, a fill lasting STATS_LONG_FILL_FACTOR times longer
+// points at a leak, a dry intake or a stuck high float.
+void taskStats() {
+  if (millis() - stats.bucketStartedAt >= STATS_BUCKET_MS) {
+    stats.bucketStartedAt = millis();
+    stats.startsBucket = (stats.startsBucket + 1) % STATS_BUCKETS;
+    stats.starts[stats.startsBucket] = 0;
+  }
+
+  const PumpControl &pump = mainTank.pump;
+  if (pump.on && pump.state == PUMP_FILLING && !stats.longFill && stats.fills >= STATS_MIN_FILLS) {
+    float seconds = (millis() - stats.pumpStartedAt) / 1000.0f;
+    if (seconds > STATS_LONG_FILL_FACTOR * stats.fillMean) {
+      stats.longFill = true;
+      statsChanged = true;
+      markStatusChanged();
+      logEvent(EVENT_LONG_FILL, 0);
+      LOG_WARN("Fill running %lu s, mean is %lu s", (unsigned long)seconds, (unsigned long)stats.fillMean);
+    }
+  }
+}
+
+void formatStatsJson(char *json, size_t size) {
+  unsigned cyclesPerHour = 0;
+  for (uint8_t i = 0; i < STATS_BUCKETS; i++) {
+    cyclesPerHour += stats.starts[i];
+  }
+  const PumpControl &pump = mainTank.pump;
+  unsigned long runSeconds = stats.runSeconds + (pump.on ? (millis() - stats.pumpStartedAt) / 1000 : 0);
+  long sinceFull = stats.fills > 0 ? (long)((millis() - stats.lastFullAt) / 1000) : -1;
+
+  snprintf(json, size,
+           "{\"fills\":%lu,\"fillMean\":%lu,\"fillStddev\":%lu,\"cyclesPerHour\":%u,"
+           "\"runSeconds\":%lu,\"sinceFull\":%ld,\"fillElapsed\":%lu,\"longFill\":%s}",
+           (unsigned long)stats.fills, (unsigned long)(stats.fillMean + 0.5f),
+           (unsigned long)(statsFillStddev() + 0.5f), cyclesPerHour, runSeconds, sinceFull,
+           pump.on ? (millis() - stats.pumpStartedAt) / 1000 : 0UL,
+           stats.longFill ? "true" : "false");
+}
+
+// Appends to the log ring. A message identical to the newest entry only
+// bumps a repeat counter; the count is written out as its own entry when a
+// different message arrives.
+void logPrintf(uint8_t level, const char *format, ...) {
+  char message[LOG_MESSAGE_MAX];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(message, sizeof(message), format, args);
+  va_end(args);
+
+  LOG_RING_LOCK();
+  if (logHead > 0) {
+    const LogEntry &newest = logRing[(logHead - 1) % LOG_RING_SIZE];
+    if (newest.level == level && strcmp(newest.message, message) == 0) {
+      if (logRepeats < UINT16_MAX) {
+        logRepeats++;
+      }
+      LOG_RING_UNLOCK();
+      return;
+    }
+  }
+
+  if (logRepeats > 0) {
+    LogEntry &summary = logRing[logHead++ % LOG_RING_SIZE];
+    summary.time = millis();
+    summary.level = logRing[(logHead - 2) % LOG_RING_SIZE].level;
+    snprintf(summary.message, sizeof(summary.message), "(last message repeated %u times)", logRepeats);
+    logRepeats = 0;
+  }
+
+  LogEntry &entry = logRing[logHead++ % LOG_RING_SIZE];
+  entry.time = millis();
+  entry.level = level;
+  memcpy(entry.message, message, sizeof(message));
+  LOG_RING_UNLOCK();
+}
+
+// Copy of the ring entry with running index `index`.
+LogEntry logEntryAt(uint32_t index) {
+  LOG_RING_LOCK();
+  LogEntry entry = logRing[index % LOG_RING_SIZE];
+  LOG_RING_UNLOCK();
+  return entry;
+}
+
+// Returns the length written, "<seconds>.<ms> <level> <message>\r\n".
+size_t formatLogLine(const LogEntry &entry, char *line, size_t size) {
+  int n = snprintf(line, size, "%lu.%03lu %c %s\r\n", entry.time / 1000, entry.time % 1000,
+                   LOG_LEVEL_CHARS[entry.level], entry.message);
+  return n < 0 ? 0 : min((size_t)n, size - 1);
+}
+
+// Drains the ring to Serial without ever blocking on the UART: a line is
+// only written once the TX FIFO has room for all of it. Warnings and errors
+// are also published, unretained, to mqttBase "log".
+void taskLog() {
+  if (logHead - logSerialTail > LOG_RING_SIZE) {
+    Serial.printf("... %lu log entries dropped\r\n", (unsigned long)(logHead - logSerialTail - LOG_RING_SIZE));
+    logSerialTail = logHead - LOG_RING_SIZE;
+  }
+  while (logSerialTail < logHead) {
+    char line[LOG_MESSAGE_MAX + 24];
+    size_t length = formatLogLine(logEntryAt(logSerialTail), line, sizeof(line));
+    if ((size_t)Serial.availableForWrite() < length) {
+      break;
+    }
+    Serial.write((const uint8_t *)line, length);
+    logSerialTail++;
+  }
+
+  if (!client.connected()) {
+    logMqttTail = logHead;  // Nothing is kept back for a broker that isn't there
+    return;
+  }
+  if (logHead - logMqttTail > LOG_RING_SIZE) {
+    logMqttTail = logHead - LOG_RING_SIZE;
+  }
+  if (logMqttTail < logHead) {
+    LogEntry entry = logEntryAt(logMqttTail);
+    if (entry.level <= LOG_MQTT_LEVEL) {
+      char topic[MQTT_TOPIC_MAX];
+      char line[LOG_MESSAGE_MAX + 24];
+      snprintf(topic, sizeof(topic), "%slog", mqttBase);
+      formatLogLine(entry, line, sizeof(line));
+      client.publish(topic, line);
+    }
+    logMqttTail++;  // One per pass so a burst cannot stall the loop
+  }
+}
+
+// Pushes the /api/status frame to every open dashboard when the status
+// version moves. The 100 ms period batches changes that land together; when
+// nothing changes nothing is sent. A client whose queue is still full is
+// given the newest frame on a later pass instead of a backlog.
+void taskPush() {
+  if (pushVersion == statusVersion || ws.count() == 0 || !ws.availableForWriteAll()) {
+    return;
+  }
+
+  char json[STATUS_JSON_MAX];
+  formatStatusJson(json, sizeof(json));
+  ws.textAll(json);
+  pushVersion = statusVersion;
+}
+
+bool publishTelemetry(const char *suffix, const char *json) {
+  char topic[MQTT_TOPIC_MAX];
+  snprintf(topic, sizeof(topic), "%s%s", mqttBase, suffix);
+  return client.publish(topic, json, true);
+}
+
+// Request handlers run in the TCP stack's context, between loop() passes
+// and whenever loop() yields (e.g. inside an MQTT connect attempt), so a slow
+// broker no longer stalls the dashboard. Several clients are served at
+// once. Handlers only read state and must not block: saving settings is
+// handed to taskWeb(), and long bodies are produced piece by piece as the
+// TCP window opens instead of being built in RAM.
+void setupWebServer() {
+  for (const WebAsset &asset : WEB_ASSETS) {
+    server.on(asset.path, HTTP_GET, [&asset](AsyncWebServerRequest *request) { sendWebAsset(request, asset); });
+  }
+
+  server.on("/api/status", HTTP_GET, handleStatusApi);
+  server.on("/api/config", HTTP_GET, handleConfigApi);
+  server.on("/api/stats", HTTP_GET, [](AsyncWebServerRequest *request) {
+    char json[224];
+    formatStatsJson(json, sizeof(json));
+    AsyncWebServerResponse *response = request->beginResponse(200, "application/json", json);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+  });
+  server.on("/log", HTTP_GET, handleLogDump);
+  server.on("/metrics", HTTP_GET, handleMetrics);
+#if SOAK_TEST
+  server.on("/soak.json", HTTP_GET, handleSoakReport);
+#endif
+  server.on("/events.csv", HTTP_GET, handleEventsCsv);
+  server.on("/events.bin", HTTP_GET, handleEventsBinary);
+  server.on("/save", HTTP_POST, handleSave);
+  server.onNotFound([](AsyncWebServerRequest *request) {
+    // On the setup AP every host name lands here; send OS connectivity
+    // checks (generate_204, hotspot-detect.html, ...) to the setup page
+    String ap = WiFi.softAPIP().toString();
+    if (apMode && request->host() != ap) {
+      request->redirect(String("http://") + ap + "/setup");
+      return;
+    }
+    request->send(404);
+  });
+
+  ws.onEvent(onWebSocketEvent);
+  server.addHandler(&ws);
+}
+
+// Copies the posted fields over the settings; empty fields keep their
+// value. Several posts before taskWeb() runs are merged.
+void handleSave(AsyncWebServerRequest *request) {
+  CONFIG_LOCK();
+  if (!configSavePending) {
+    pendingConfig = config;
+  }
+  Config &next = pendingConfig;
+
+  const String &newSSID = request->arg("ssid");
+  const String &newPass = request->arg("wifipass");
+  const String &newMQTT = request->arg("server");
+  const String &newUser = request->arg("user");
+  const String &newPassMQTT = request->arg("pass");
+  int newPort = request->arg("port").toInt();
+
+  if (newSSID.length() > 0) newSSID.toCharArray(next.wifi_ssid, sizeof(next.wifi_ssid));
+  if (newPass.length() > 0) newPass.toCharArray(next.wifi_password, sizeof(next.wifi_password));
+  if (newMQTT.length() > 0) newMQTT.toCharArray(next.mqtt_server, sizeof(next.mqtt_server));
+  if (newUser.length() > 0) newUser.toCharArray(next.mqtt_user, sizeof(next.mqtt_user));
+  if (newPassMQTT.length() > 0) newPassMQTT.toCharArray(next.mqtt_password, sizeof(next.mqtt_password));
+  if (newPort > 0) next.mqtt_port = newPort;
+  if (request->hasArg("prefix")) {
+    const String &prefix = request->arg("prefix");
+    const String &group = request->arg("group");  // Empty takes the unit out of its group
+    if (prefix.length() > 0 && prefix.length() < sizeof(next.mqtt_prefix) && mqttTopicNameValid(prefix.c_str(), true)) {
+      prefix.toCharArray(next.mqtt_prefix, sizeof(next.mqtt_prefix));
+    }
+    if (group.length() < sizeof(next.mqtt_group) && (group.length() == 0 || mqttTopicNameValid(group.c_str(), false))) {
+      group.toCharArray(next.mqtt_group, sizeof(next.mqtt_group));
+    }
+  }
+  if (request->hasArg("tls")) {
+    long tls = request->arg("tls").toInt();
+    const String &fingerprint = request->arg("fingerprint");
+    if (tls >= MQTT_TLS_OFF && tls <= MQTT_TLS_CA) next.mqtt_tls = tls;
+    if (fingerprint.length() > 0) fingerprint.toCharArray(next.mqtt_fingerprint, sizeof(next.mqtt_fingerprint));
+  }
+
+  if (request->hasArg("sensor")) {
+    long sensor = request->arg("sensor").toInt();
+    long start = request->arg("levelStart").length() > 0 ? request->arg("levelStart").toInt() : next.level_start;
+    long stop = request->arg("levelStop").length() > 0 ? request->arg("levelStop").toInt() : next.level_stop;
+    if (sensor >= 0 && sensor < (long)LEVEL_DRIVER_COUNT) next.sensor_type = sensor;
+    if (start >= 0 && stop <= 100 && start < stop) {
+      next.level_start = start;
+      next.level_stop = stop;
+    }
+    if (request->arg("calEmpty").length() > 0) next.cal_empty = constrain(request->arg("calEmpty").toInt(), 0L, 65535L);
+    if (request->arg("calFull").length() > 0) next.cal_full = constrain(request->arg("calFull").toInt(), 0L, 65535L);
+  }
+
+  if (request->arg("flowPulses").length() > 0) {
+    next.flow_pulses_per_litre = constrain(request->arg("flowPulses").toInt(), 0L, 65535L);
+  }
+
+  if (request->hasArg("power")) {
+    long mode = request->arg("power").toInt();
+    if (mode >= POWER_ALWAYS_ON && mode <= POWER_LIGHT_SLEEP) next.power_mode = mode;
+    if (request->arg("powerLatency").length() > 0) {
+      next.power_latency_ms = constrain(request->arg("powerLatency").toInt(), (long)POWER_LATENCY_MIN_MS, (long)POWER_LATENCY_MAX_MS);
+    }
+  }
+
+  if (request->hasArg("tz")) {
+    const String &ntp = request->arg("ntp");
+    const String &tz = request->arg("tz");
+    if (ntp.length() > 0) ntp.toCharArray(next.ntp_server, sizeof(next.ntp_server));
+    if (tz.length() > 0) tz.toCharArray(next.timezone, sizeof(next.timezone));
+    for (int i = 0; i < SCHEDULE_RULES; i++) {
+      const String &text = request->arg(String("rule") + i);
+      if (!scheduleParseRule(text.length() > 0 ? text.c_str() : "off", text.length() > 0 ? text.length() : 3, next.schedule[i])) {
+        LOG_WARN("Schedule rule %d not understood: %s", i, text.c_str());
+      }
+    }
+  }
+
+  configSavePending = true;
+  CONFIG_UNLOCK();
+  request->send(200, "text/html", "<html><body><h3>Settings Saved!</h3><a href='/'>Go Back</a></body></html>");
+}
+
+// Dashboard push channel, see taskPush(). A new client gets the current
+// frame straight away. Clients only listen; anything they send is ignored.
+void onWebSocketEvent(AsyncWebSocket *socket, AsyncWebSocketClient *wsClient, AwsEventType type, void *arg, uint8_t *data, size_t length) {
+  if (type == WS_EVT_CONNECT) {
+    char json[STATUS_JSON_MAX];
+    formatStatusJson(json, sizeof(json));
+    wsClient->text(json);
+    LOG_DEBUG("WebSocket client %lu connected (%u open)", (unsigned long)wsClient->id(), (unsigned)socket->count());
+  } else if (type == WS_EVT_DISCONNECT) {
+    LOG_DEBUG("WebSocket client %lu disconnected", (unsigned long)wsClient->id());
+  }
+}
+
+// Sends a chunked response whose body comes from `next`. A piece larger than
+// the room the TCP stack offers is carried over into the following chunk.
+void sendStream(AsyncWebServerRequest *request, const char *contentType, ChunkSource next) {
+  struct Carry {
+    ChunkSource next;
+    uint8_t piece[WEB_PIECE_MAX];
+    size_t length;
+    size_t offset;
+    bool done;
+  };
+  std::shared_ptr<Carry> carry = std::make_shared<Carry>();
+  carry->next = next;
+  carry->length = 0;
+  carry->offset = 0;
+  carry->done = false;
+
+  AsyncWebServerResponse *response = request->beginChunkedResponse(contentType,
+    [carry](uint8_t *buffer, size_t maxLength, size_t) -> size_t {
+      size_t n = 0;
+      while (n < maxLength && !carry->done) {
+        if (carry->offset == carry->length) {
+          carry->length = carry->next(carry->piece, sizeof(carry->piece));
+          carry->offset = 0;
+          carry->done = carry->length == 0;
+          continue;
+        }
+        size_t chunk = min(maxLength - n, carry->length - carry->offset);
+        memcpy(buffer + n, carry->piece + carry->offset, chunk);
+        carry->offset += chunk;
+        n += chunk;
+      }
+      return n;  // 0 ends the response
+    });
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
+}
+
+// Static pages are stored pre-compressed in flash (see web/ and
+// tools/build_web_assets.py) and streamed as-is. They carry no per-request
+// data, so browsers may cache them; the ETag changes with the content.
+void sendWebAsset(AsyncWebServerRequest *request, const WebAsset &asset) {
+  AsyncWebServerResponse *response;
+  if (request->hasHeader("If-None-Match") && request->header("If-None-Match") == asset.etag) {
+    response = request->beginResponse(304);  // Same validators as the 200, so the cache entry is refreshed
+  } else {
+    response = request->beginResponse_P(200, asset.contentType, asset.data, asset.length);
+    response->addHeader("Content-Encoding", "gzip");
+  }
+  response->addHeader("Cache-Control", "max-age=86400");
+  response->addHeader("ETag", asset.etag);
+  request->send(response);
+}
+
+// Current settings for the /setup form. Passwords are never sent back.
+void handleConfigApi(AsyncWebServerRequest *request) {
+  AsyncResponseStream *response = request->beginResponseStream("application/json");
+  response->addHeader("Cache-Control", "no-store");
+  char escaped[2 * sizeof(config.wifi_ssid)];  // Big enough for every string field
+
+  CONFIG_LOCK();
+  jsonEscape(config.wifi_ssid, escaped, sizeof(escaped));
+  response->printf("{\"ssid\":\"%s\"", escaped);
+  jsonEscape(config.mqtt_server, escaped, sizeof(escaped));
+  response->printf(",\"server\":\"%s\",\"port\":%d", escaped, config.mqtt_port);
+  jsonEscape(config.mqtt_user, escaped, sizeof(escaped));
+  response->printf(",\"user\":\"%s\",\"device\":\"%s\"", escaped, deviceId);
+  jsonEscape(config.mqtt_prefix, escaped, sizeof(escaped));
+  response->printf(",\"prefix\":\"%s\"", escaped);
+  jsonEscape(config.mqtt_group, escaped, sizeof(escaped));
+  response->printf(",\"group\":\"%s\",\"tls\":%u,\"caBuiltIn\":%s", escaped, config.mqtt_tls,
+                   MQTT_CA_ENABLED ? "true" : "false");
+  jsonEscape(config.mqtt_fingerprint, escaped, sizeof(escaped));
+  response->printf(",\"fingerprint\":\"%s\"", escaped);
+  response->printf(",\"sensor\":%u,\"levelStart\":%u,\"levelStop\":%u,\"calEmpty\":%u,\"calFull\":%u",
+                   config.sensor_type, config.level_start, config.level_stop, config.cal_empty, config.cal_full);
+  response->printf(",\"flowPulses\":%u", config.flow_pulses_per_litre);
+  response->printf(",\"power\":%u,\"powerLatency\":%u", config.power_mode, config.power_latency_ms);
+  jsonEscape(config.ntp_server, escaped, sizeof(escaped));
+  response->printf(",\"ntp\":\"%s\"", escaped);
+  jsonEscape(config.timezone, escaped, sizeof(escaped));
+  response->printf(",\"tz\":\"%s\",\"rules\":[", escaped);
+  for (int i = 0; i < SCHEDULE_RULES; i++) {
+    char rule[SCHEDULE_RULE_TEXT_MAX];
+    scheduleFormatRule(config.schedule[i], rule, sizeof(rule));
+    response->printf("%s\"%s\"", i ? "," : "", rule);
+  }
+  CONFIG_UNLOCK();
+  response->print("]}");
+  request->send(response);
+}
+
+// Copies `in` to `out` with JSON string escaping, truncating to fit.
+void jsonEscape(const char *in, char *out, size_t outSize) {
+  size_t n = 0;
+  for (; *in && n + 2 < outSize; in++) {
+    char c = *in;
+    if (c == '"' || c == '\\') {
+      out[n++] = '\\';
+      out[n++] = c;
+    } else if ((uint8_t)c >= 0x20) {
+      out[n++] = c;
+    }
+  }
+  out[n] = '\0';
+}
+
+// Recent log entries as plain text, oldest first, streamed line by line.
+// Entries logged while the response is going out are left for the next dump.
+void handleLogDump(AsyncWebServerRequest *request) {
+  uint32_t next = logHead > LOG_RING_SIZE ? logHead - LOG_RING_SIZE : 0;
+  uint32_t end = logHead;
+  bool repeatsSent = false;
+
+  sendStream(request, "text/plain", [next, end, repeatsSent](uint8_t *buffer, size_t size) mutable -> size_t {
+    if (next + LOG_RING_SIZE < logHead) {
+      next = logHead - LOG_RING_SIZE;  // Overwritten while waiting for the client
+    }
+    if (next < end) {
+      return formatLogLine(logEntryAt(next++), (char *)buffer, size);
+    }
+    if (logRepeats > 0 && logHead == end && !repeatsSent) {
+      repeatsSent = true;
+      return snprintf((char *)buffer, size, "(last message repeated %u times)\r\n", logRepeats);
+    }
+    return 0;
+  });
+}
+
+// Prometheus text exposition of loop timing, task timing, heap and link
+// counters. The body is a few KB, so it is printed into a stream buffer.
+void handleMetrics(AsyncWebServerRequest *request) {
+  AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+  uint32_t cyclesPerUs = ESP.getCpuFreqMHz();
+
+  // Each family's samples must follow its TYPE line together
+  response->print("# TYPE watertank_task_runs_total counter\n");
+  for (size_t i = 0; i < TASK_COUNT; i++) {
+    response->printf("watertank_task_runs_total{task=\"%s\"} %lu\n", tasks[i].name, (unsigned long)tasks[i].runs);
+  }
+  response->print("# TYPE watertank_task_overruns_total counter\n");
+  for (size_t i = 0; i < TASK_COUNT; i++) {
+    response->printf("watertank_task_overruns_total{task=\"%s\"} %lu\n", tasks[i].name, tasks[i].overruns);
+  }
+  response->print("# TYPE watertank_task_seconds gauge\n");
+  for (size_t i = 0; i < TASK_COUNT; i++) {
+    const Task &task = tasks[i];
+    response->printf("watertank_task_seconds{task=\"%s\",stat=\"min\"} %.6f\n"
+                     "watertank_task_seconds{task=\"%s\",stat=\"max\"} %.6f\n"
+                     "watertank_task_seconds{task=\"%s\",stat=\"avg\"} %.6f\n",
+                     task.name, task.minCycles / (cyclesPerUs * 1e6),
+                     task.name, task.maxCycles / (cyclesPerUs * 1e6),
+                     task.name, task.avgCycles / (cyclesPerUs * 1e6));
+  }
+
+  response->print("# TYPE watertank_loop_interval_seconds histogram\n");
+  uint32_t cumulative = 0;
+  for (size_t i = 0; i <= LOOP_BUCKET_COUNT; i++) {
+    cumulative += loopHistogram[i];
+    if (i < LOOP_BUCKET_COUNT) {
+      response->printf("watertank_loop_interval_seconds_bucket{le=\"%g\"} %lu\n",
+                       LOOP_BUCKETS_US[i] / 1e6, (unsigned long)cumulative);
+    } else {
+      response->printf("watertank_loop_interval_seconds_bucket{le=\"+Inf\"} %lu\n", (unsigned long)cumulative);
+    }
+  }
+  response->printf("watertank_loop_interval_seconds_sum %.6f\nwatertank_loop_interval_seconds_count %lu\n",
+                   loopTotalUs / 1e6, (unsigned long)loopPasses);
+  response->printf("# TYPE watertank_loop_interval_max_seconds gauge\nwatertank_loop_interval_max_seconds %.6f\n",
+                   loopMaxUs / 1e6);
+
+  response->printf("# TYPE watertank_heap_free_bytes gauge\nwatertank_heap_free_bytes %lu\n"
+                   "# TYPE watertank_heap_max_block_bytes gauge\nwatertank_heap_max_block_bytes %lu\n",
+                   (unsigned long)ESP.getFreeHeap(), (unsigned long)heapMaxBlock());
+  response->printf("# TYPE watertank_heap_fragmentation_percent gauge\nwatertank_heap_fragmentation_percent %u\n",
+                   heapFragmentation());
+
+  response->printf("# TYPE watertank_wifi_rssi_dbm gauge\nwatertank_wifi_rssi_dbm %d\n"
+                   "# TYPE watertank_wifi_reconnects_total counter\nwatertank_wifi_reconnects_total %lu\n",
+                   WiFi.status() == WL_CONNECTED ? (int)WiFi.RSSI() : 0, (unsigned long)wifiReconnects);
+  response->printf("# TYPE watertank_mqtt_connects_total counter\nwatertank_mqtt_connects_total %lu\n"
+                   "# TYPE watertank_mqtt_connect_failures_total counter\nwatertank_mqtt_connect_failures_total %lu\n",
+                   (unsigned long)mqttConnects, (unsigned long)mqttConnectFailures);
+  response->printf("# TYPE watertank_mqtt_connect_seconds gauge\nwatertank_mqtt_connect_seconds %.3f\n"
+                   "# TYPE watertank_mqtt_tls gauge\nwatertank_mqtt_tls %d\n",
+                   mqttConnectMs / 1e3, config.mqtt_tls != MQTT_TLS_OFF ? 1 : 0);
+  if (flow.pulsesPerLitre > 0) {
+    response->printf("# TYPE watertank_flow_litres_total counter\nwatertank_flow_litres_total %.3f\n"
+                     "# TYPE watertank_flow_rate_litres_per_minute gauge\nwatertank_flow_rate_litres_per_minute %.3f\n"
+                     "# TYPE watertank_flow_fault gauge\nwatertank_flow_fault %d\n",
+                     flowMeterMillilitres(flow, flow.totalPulses) / 1e3, flow.rateMlPerMin / 1e3, flow.fault ? 1 : 0);
+  }
+  response->printf("# TYPE watertank_events_dropped_total counter\nwatertank_events_dropped_total %lu\n",
+                   (unsigned long)eventsDropped);
+  response->printf("# TYPE watertank_power_idle_seconds_total counter\nwatertank_power_idle_seconds_total %.3f\n"
+                   "# TYPE watertank_power_light_sleep gauge\nwatertank_power_light_sleep %d\n",
+                   powerIdleMs / 1e3, powerSleeping ? 1 : 0);
+  response->printf("# TYPE watertank_uptime_seconds counter\nwatertank_uptime_seconds %lu\n", millis() / 1000);
+  request->send(response);
+}
+
+// Condensed metrics for MQTT: average and max run time of each task in us,
+// worst loop pass, heap shape and link counters.
+void formatMetricsJson(char *json, size_t size) {
+  uint32_t cyclesPerUs = ESP.getCpuFreqMHz();
+  int n = snprintf(json, size, "{\"loopMaxUs\":%lu,\"heapFrag\":%u,\"maxBlock\":%lu,\"wifiReconnects\":%lu,"
+                   "\"mqttConnects\":%lu,\"mqttFailures\":%lu,\"tasks\":{",
+                   (unsigned long)loopMaxUs, heapFragmentation(), (unsigned long)heapMaxBlock(),
+                   (unsigned long)wifiReconnects, (unsigned long)mqttConnects, (unsigned long)mqttConnectFailures);
+  if (n < 0 || (size_t)n + 3 > size) {
+    json[0] = '\0';  // Not even the header fits
+    return;
+  }
+  // Whole entries only, with room kept for the closing braces
+  for (size_t i = 0; i < TASK_COUNT; i++) {
+    char entry[48];
+    int length = snprintf(entry, sizeof(entry), "%s\"%s\":[%lu,%lu]", i ? "," : "", tasks[i].name,
+                          (unsigned long)(tasks[i].avgCycles / cyclesPerUs), (unsigned long)(tasks[i].maxCycles / cyclesPerUs));
+    if (length < 0 || (size_t)length >= sizeof(entry) || (size_t)(n + length) + 3 > size) {
+      break;
+    }
+    memcpy(json + n, entry, length);
+    n += length;
+  }
+  memcpy(json + n, "}}", 3);
+}
+
+void markStatusChanged() {
+#if defined(ESP32)
+  __atomic_add_fetch(&statusVersion, 1, __ATOMIC_RELAXED);  // Bumped from both cores
+#else
+  statusVersion++;
+#endif
+}
+
+// Largest block malloc() can hand out, and how far that is below the
+// free total, in %.
+uint32_t heapMaxBlock() {
+#if defined(ESP32)
+  return ESP.getMaxAllocHeap();
+#else
+  return ESP.getMaxFreeBlockSize();
+#endif
+}
+
+uint8_t heapFragmentation() {
+#if defined(ESP32)
+  uint32_t free = ESP.getFreeHeap();
+  return free > 0 ? 100 - (uint64_t)ESP.getMaxAllocHeap() * 100 / free : 0;
+#else
+  return ESP.getHeapFragmentation();
+#endif
+}
+
+// Version token of the status frame: the boot nonce and statusVersion.
+void formatStatusToken(char *token, size_t size) {
+  snprintf(token, size, "%08lx-%lu", (unsigned long)bootNonce, (unsigned long)statusVersion);
+}
+
+// Compact status for the dashboard. Clients that already hold the current
+// version (If-None-Match: "<v>" or ?since=<v>) get a bodyless 304.
+void handleStatusApi(AsyncWebServerRequest *request) {
+  char token[24];
+  formatStatusToken(token, sizeof(token));
+  char etag[28];
+  snprintf(etag, sizeof(etag), "\"%s\"", token);
+
+  if ((request->hasHeader("If-None-Match") && request->header("If-None-Match") == etag) ||
+      (request->hasParam("since") && request->getParam("since")->value() == token)) {
+    AsyncWebServerResponse *response = request->beginResponse(304);
+    response->addHeader("ETag", etag);
+    request->send(response);
+    return;
+  }
+
+  char json[STATUS_JSON_MAX];
+  formatStatusJson(json, sizeof(json));
+
+  AsyncWebServerResponse *response = request->beginResponse(200, "application/json", json);
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
+}
+
+// Status frame shared by /api/status and the /ws push. The main tank's
+// fields are at the top level; other channels are listed in "tanks".
+void formatStatusJson(char *json, size_t size) {
+  char flowJson[64];
+  formatFlowJson(flowJson, sizeof(flowJson));
+  char token[24];
+  formatStatusToken(token, sizeof(token));
+  int n = snprintf(json, size,
+                   "{\"v\":\"%s\",\"wifi\":%s,\"mqtt\":%s,\"low\":%s,\"high\":%s,"
+                   "\"pump\":%s,\"state\":\"%s\",\"override\":%s,\"longFill\":%s,"
+                   "\"level\":%u,\"sensorFault\":%s,\"window\":\"%s\"%s,\"tanks\":[",
+                   token,
+                   WiFi.status() == WL_CONNECTED ? "true" : "false",
+                   client.connected() ? "true" : "false",
+                   mainTank.low ? "true" : "false",
+                   mainTank.high ? "true" : "false",
+                   mainTank.pump.on ? "true" : "false",
+                   PUMP_STATE_NAMES[mainTank.pump.state],
+                   mainTank.overrideMode ? "true" : "false",
+                   stats.longFill ? "true" : "false",
+                   mainTank.level,
+                   mainTank.fault ? "true" : "false",
+                   SCHEDULE_ACTION_NAMES[scheduleAction], flowJson);
+  for (size_t i = 1; i < CHANNEL_COUNT && n > 0 && (size_t)n < size; i++) {
+    const Channel &ch = channels[i];
+    n += snprintf(json + n, size - n, "%s{\"id\":\"%s\",\"low\":%s,\"high\":%s,\"pump\":%s,\"state\":\"%s\",\"override\":%s}",
+                  i > 1 ? "," : "", ch.id, ch.low ? "true" : "false", ch.high ? "true" : "false",
+                  ch.pump.on ? "true" : "false", PUMP_STATE_NAMES[ch.pump.state], ch.overrideMode ? "true" : "false");
+  }
+  if (n > 0 && (size_t)n < size) {
+    snprintf(json + n, size - n, "]}");
+  }
+}
+
+// Sampler ISR: take one sample of every float switch and update its vote.
+void IRAM_ATTR onSampleTimer() {
+  for (Channel &ch : channels) {
+    for (SensorFilter &f : ch.filters) {
+      sensorFilterSample(f, halDigitalRead(f.pin));  // HIGH means submerged (water detected)
+    }
+  }
+}
+
+void startSensorSampler() {
+  for (Channel &ch : channels) {
+    for (SensorFilter &f : ch.filters) {
+      sensorFilterSeed(f, halDigitalRead(f.pin));
+    }
+  }
+
+#if defined(ESP32)
+  static hw_timer_t *timer = timerBegin(0, ESP32_TIMER_DIVIDER, true);  // Only started once, at boot
+  timerAttachInterrupt(timer, onSampleTimer, true);
+  timerAlarmWrite(timer, SAMPLE_INTERVAL_US, true);
+  timerAlarmEnable(timer);
+#else
+  timer1_attachInterrupt(onSampleTimer);
+  timer1_enable(TIM_DIV16, TIM_EDGE, TIM_LOOP);
+  timer1_write(SAMPLE_INTERVAL_US * TIMER1_TICKS_PER_US);
+#endif
+}
+
+// Queues a command for the control side. False, so the MQTT ack says so,
+// when the queue is full.
+bool postControl(ControlCommandType type, size_t channel, uint8_t arg) {
+  ControlCommand command = { type, (uint8_t)channel, arg };
+  if (!spscPush(controlQueue, command)) {
+    LOG_WARN("Control queue full, command dropped");
+    return false;
+  }
+  return true;
+}
+
+// Takes the control side's copy of the settings it uses. The only place
+// the control side reads `config`.
+void copyControlSettings() {
+  CONFIG_LOCK();
+  controlSettings.sensorType = config.sensor_type;
+  controlSettings.levelStart = config.level_start;
+  controlSettings.levelStop = config.level_stop;
+  controlSettings.calEmpty = config.cal_empty;
+  controlSettings.calFull = config.cal_full;
+  controlSettings.flowPulsesPerLitre = config.flow_pulses_per_litre;
+  memcpy(controlSettings.schedule, config.schedule, sizeof(controlSettings.schedule));
+  CONFIG_UNLOCK();
+}
+
+// Applies the commands the network side queued since the last tick.
+void applyControlCommands() {
+  ControlCommand command;
+  while (spscPop(controlQueue, command)) {
+    Channel &ch = channels[command.channel];
+    switch (command.type) {
+      case CONTROL_OVERRIDE:
+        ch.overrideMode = command.arg != OVERRIDE_AUTO;
+        ch.overrideState = command.arg == OVERRIDE_ON;
+        markStatusChanged();
+        logEvent(EVENT_OVERRIDE, command.channel);
+        break;
+      case CONTROL_FLOW_RESET:
+        flowMeterClearFault(flow);
+        LOG_INFO("No-flow fault reset");
+        markStatusChanged();
+        break;
+      case CONTROL_SENSOR_RESTART:
+        copyControlSettings();
+        beginLevelSensor();
+        break;
+      case CONTROL_FLOW_RESTART:
+        copyControlSettings();
+        beginFlowMeter();  // Drops a fault latched under the old setting
+        break;
+      case CONTROL_SCHEDULE_CHANGED:
+        copyControlSettings();  // taskSchedule() applies the new rules on its next run
+        break;
+    }
+    ch.eventPending = true;
+  }
+}
+
+// Runs each channel whose pump has a sensor edge, override command or
+// schedule change pending. The relay itself is switched by
+// pumpControlUpdate(); this adds the logging, the statistics and the event
+// log entries.
+void handlePumpLogic() {
+  applyControlCommands();
+  for (size_t i = 0; i < CHANNEL_COUNT; i++) {
+    Channel &ch = channels[i];
+    if (!ch.eventPending) {
+      continue;
+    }
+
+    const Channel *source = ch.source == NO_SOURCE ? nullptr : &channels[ch.source];
+    PumpInputs inputs = {};
+    inputs.low = ch.low;
+    inputs.high = ch.high;
+    inputs.fault = ch.fault;
+    inputs.overrideMode = ch.overrideMode;
+    inputs.overrideState = ch.overrideState;
+    inputs.topUp = scheduleAction == SCHEDULE_TOP_UP;
+    inputs.peak = scheduleAction == SCHEDULE_PEAK;
+    inputs.sourceLow = source && (!source->low || source->fault);
+    inputs.noFlow = i == 0 && flow.fault;  // The flow meter sits on the main pump
+    PumpStep step = pumpControlUpdate(ch.pump, inputs);
+    if (step.deferred) {
+      continue;  // Leave the event pending and retry on the next tick
+    }
+
+    ch.eventPending = false;
+
+    if (step.stateChanged) {
+      if (i == 0 && step.previous == PUMP_FILLING && ch.pump.state == PUMP_FULL) {
+        statsFillCompleted();
+      }
+      LOG_INFO("%s: Pump state: %s -> %s", ch.id, PUMP_STATE_NAMES[step.previous], PUMP_STATE_NAMES[ch.pump.state]);
+      markStatusChanged();
+      logEvent(EVENT_STATE, i);
+    }
+    if (step.relayChanged) {
+      if (i == 0 && ch.pump.on) {
+        statsPumpStarted();
+      } else if (i == 0) {
+        statsPumpStopped();
+      }
+      markStatusChanged();
+      logEvent(ch.pump.on ? EVENT_PUMP_ON : EVENT_PUMP_OFF, i);
+      LOG_INFO("%s: Pump turned %s", ch.id, ch.pump.on ? "ON" : "OFF");
+    }
+  }
+}
+
+// True while any channel's pump runs.
+bool anyPumpOn() {
+  for (const Channel &ch : channels) {
+    if (ch.pump.on) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void handleLED() {
+  if (WiFi.status() == WL_CONNECTED) {
+    setLed(config.power_mode == POWER_ALWAYS_ON);  // ON, or off to save power
+  } else {
+    static unsigned long lastBlinkTime = 0;
+    static bool ledState = false;
+
+    if (millis() - lastBlinkTime >= 500) {  // Blink every 500ms
+      lastBlinkTime = millis();
+      ledState = !ledState;
+      setLed(ledState);
+    }
+  }
+}
+
+void setLed(bool on) {
+  halDigitalWrite(BOARD.ledPin, on != BOARD.ledActiveLow);
+}
+
+// Every command, whether sent to this unit, its group or all units, is
+// acknowledged on mqttBase "ack", so a fleet command can be checked off per
+// device. ok is false for a payload the handler did not accept.
+void mqttCallback(char* topic, byte* payload, unsigned int length) {
+  MqttResult result = MQTT_NO_ROUTE;
+  for (const char *base : MQTT_COMMAND_BASES) {
+    if (base[0] != '\0' && (result = dispatchCommand(base, topic, payload, length)) != MQTT_NO_ROUTE) {
+      break;
+    }
+  }
+  if (result == MQTT_NO_ROUTE) {
+    return;
+  }
+
+  // topic points into the client's buffer, which publish() reuses
+  char escaped[2 * MQTT_TOPIC_MAX];
+  char ack[2 * MQTT_TOPIC_MAX + 32];
+  char ackTopic[MQTT_TOPIC_MAX];
+  jsonEscape(topic, escaped, sizeof(escaped));
+  snprintf(ack, sizeof(ack), "{\"topic\":\"%s\",\"ok\":%s}", escaped, result == MQTT_ACCEPTED ? "true" : "false");
+  snprintf(ackTopic, sizeof(ackTopic), "%sack", mqttBase);
+  client.publish(ackTopic, ack);
+}
+
+MqttResult dispatchCommand(const char *base, const char *topic, const byte *payload, unsigned int length) {
+  commandChannel = &mainTank;
+  MqttResult result = mqttDispatch(MQTT_ROUTES, MQTT_ROUTE_COUNT, base, topic, payload, length);
+  for (size_t i = 0; i < CHANNEL_COUNT && result == MQTT_NO_ROUTE; i++) {
+    char channelBase[MQTT_TOPIC_MAX];
+    snprintf(channelBase, sizeof(channelBase), "%s%s/", base, channels[i].id);
+    commandChannel = &channels[i];
+    result = mqttDispatch(CHANNEL_ROUTES, CHANNEL_ROUTE_COUNT, channelBase, topic, payload, length);
+  }
+  return result;
+}
+
+bool onOverrideCommand(const byte *payload, unsigned int length) {
+  OverrideAction action;
+  if (payloadIs(payload, length, "ON")) {
+    action = OVERRIDE_ON;
+  } else if (payloadIs(payload, length, "OFF")) {
+    action = OVERRIDE_OFF;
+  } else if (payloadIs(payload, length, "AUTO")) {
+    action = OVERRIDE_AUTO;
+  } else {
+    return false;
+  }
+  return postControl(CONTROL_OVERRIDE, commandChannel - channels, action);
+}
+
+// Clears a latched no-flow fault so the main tank's pump may run again.
+bool onFlowResetCommand(const byte *payload, unsigned int length) {
+  if (!flow.fault) {
+    return false;
+  }
+  return postControl(CONTROL_FLOW_RESET, 0, 0);
+}
+
+// Takes one step of a connection attempt per call, so the other tasks run
+// between the steps: first the broker lookup and the transport connect
+// (TCP, plus the handshake with TLS), then on the next pass the MQTT
+// CONNECT and its CONNACK, over the open transport. PubSubClient blocks
+// inside each step, but only for its own timeout: MQTT_DNS_TIMEOUT_MS +
+// MQTT_CONNECT_TIMEOUT_MS, then MQTT_SOCKET_TIMEOUT_S; with TLS the first
+// step also carries the handshake, bounded by MQTT_TLS_TIMEOUT_MS. While
+// the broker's MFLN answer is unknown, the probe and its TCP connect take
+// a step of their own ahead of the handshake. mqttConnectMs is the longest
+// step of the attempt. On
+// failure the next attempt is scheduled with exponential backoff and random
+// jitter, so a fleet that lost its broker does not reconnect in lockstep.
+void reconnectMQTT() {
+  unsigned long started = millis();
+  if (!mqttTransport().connected()) {
+    bool probed = tlsProbeTaken;  // The probe step already counted for this attempt
+    if (!probed) {
+      LOG_DEBUG("Attempting MQTT connection...");
+    }
+    bool open = connectMqttTransport();
+    uint32_t step = millis() - started;
+    mqttConnectMs = probed ? max(mqttConnectMs, step) : step;
+    if (!open) {
+      scheduleMqttRetry("broker unreachable");
+    }
+    return;
+  }
+
+  char availability[MQTT_TOPIC_MAX];
+  snprintf(availability, sizeof(availability), "%s" MQTT_AVAILABILITY, mqttBase);
+  bool connected = client.connect(deviceId, config.mqtt_user, config.mqtt_password, availability, 1, true, "offline");
+  mqttConnectMs = max(mqttConnectMs, (uint32_t)(millis() - started));
+  if (connected) {
+    LOG_INFO("MQTT Connected as %s, %lu ms longest step", deviceId, (unsigned long)mqttConnectMs);
+    mqttConnects++;
+    client.publish(availability, "online", true);
+    // Exact topics rather than "<base>#", which would echo our own telemetry
+    for (const char *base : MQTT_COMMAND_BASES) {
+      if (base[0] == '\0') {
+        continue;
+      }
+      for (const MqttRoute &route : MQTT_ROUTES) {
+        char topic[MQTT_TOPIC_MAX];
+        snprintf(topic, sizeof(topic), "%s%s", base, route.suffix);
+        client.subscribe(topic);
+      }
+      for (const Channel &ch : channels) {
+        for (const MqttRoute &route : CHANNEL_ROUTES) {
+          char topic[MQTT_TOPIC_MAX];
+          snprintf(topic, sizeof(topic), "%s%s/%s", base, ch.id, route.suffix);
+          client.subscribe(topic);
+        }
+      }
+    }
+    mqttWasConnected = true;
+    mqttBackoff = MQTT_BACKOFF_MIN_MS;
+    telemetryHeartbeatDue = true;  // Refresh both frames on the new session
+    markStatusChanged();
+    return;
+  }
+  scheduleMqttRetry("connect refused or timed out");
+}
+
+// The transport PubSubClient runs over, see applyMqttTls().
+WiFiClient &mqttTransport() {
+  if (config.mqtt_tls != MQTT_TLS_OFF) {
+    return tlsClient;
+  }
+  return espClient;
+}
+
+// Looks the broker up with a bounded wait, then opens the transport. A TLS
+// connect looks the name up again, from lwIP's cache now, because the
+// certificate is checked against it. When the MFLN probe is due it is all
+// this step does, and true means only that the attempt goes on.
+bool connectMqttTransport() {
+  IPAddress broker;
+#if defined(ESP32)
+  bool found = WiFi.hostByName(config.mqtt_server, broker) == 1;
+#else
+  bool found = WiFi.hostByName(config.mqtt_server, broker, MQTT_DNS_TIMEOUT_MS) == 1;
+#endif
+  if (!found) {
+    return false;
+  }
+  if (config.mqtt_tls == MQTT_TLS_OFF) {
+    return espClient.connect(broker, config.mqtt_port);
+  }
+#if !defined(ESP32)
+  if (tlsProbePending && !tlsProbeTaken) {
+    probeMqttTls(broker);
+    tlsProbeTaken = true;
+    return true;
+  }
+  tlsProbeTaken = false;
+#endif
+  prepareMqttTls();
+  if (!tlsClient.connect(config.mqtt_server, config.mqtt_port)) {
+    return false;
+  }
+  tlsProbePending = false;  // Reached the broker, so the buffer size stands
+  return true;
+}
+
+void scheduleMqttRetry(const char *reason) {
+  mqttTransport().stop();
+  tlsProbeTaken = false;
+  unsigned long wait = mqttBackoff / 2 + hardwareRandom() % (mqttBackoff / 2 + 1);
+  mqttNextAttempt = millis() + wait;
+  mqttBackoff = min(mqttBackoff * 2, MQTT_BACKOFF_MAX_MS);
+
+  mqttConnectFailures++;
+  LOG_WARN("MQTT connect failed (%s), rc=%d -> Retrying in %lu ms", reason, client.state(), wait);
+  if (config.mqtt_tls != MQTT_TLS_OFF) {
+    char error[64];
+#if defined(ESP32)
+    int code = tlsClient.lastError(error, sizeof(error));
+#else
+    int code = tlsClient.getLastSSLError(error, sizeof(error));
+#endif
+    if (code != 0) {
+      LOG_WARN("TLS error %d: %s", code, error);
+    }
+  }
+}
+
+#if !defined(ESP32)
+// Asks the broker, over a throwaway TCP connect to the address already
+// looked up, whether it accepts the smaller MFLN record size, and sizes the
+// buffers for this and every later handshake. An accepted MFLN settles it.
+// A refusal looks the same as a broker that could not be reached, so it
+// only stands once a handshake with the full buffers gets through; until
+// then every attempt probes again.
+void probeMqttTls(IPAddress broker) {
+  bool mfln = tlsClient.probeMaxFragmentLength(broker, config.mqtt_port, MQTT_TLS_RX_MFLN);
+  tlsClient.setBufferSizes(mfln ? MQTT_TLS_RX_MFLN : MQTT_TLS_RX_FULL, MQTT_TLS_TX);
+  if (mfln) {
+    tlsProbePending = false;
+  }
+  LOG_INFO("TLS receive buffer %d bytes (%s)", mfln ? MQTT_TLS_RX_MFLN : MQTT_TLS_RX_FULL,
+           mfln ? "broker accepts MFLN" : "no MFLN, or broker unreachable");
+}
+#endif
+
+// Per-attempt TLS setup. The ESP32's client has fixed buffers and takes the
+// date from the system clock itself.
+void prepareMqttTls() {
+#if !defined(ESP32)
+  if (config.mqtt_tls == MQTT_TLS_CA && clockSet) {
+    tlsClient.setX509Time(time(nullptr));  // Certificate validity needs the real date
+  }
+#endif
+}
+
+// Loads the newest valid record into `config`. Runs once, at boot.
+void loadConfig() {
+#if defined(ESP32)
+  LittleFS.begin(true);  // Formats the partition on first use
+#else
+  LittleFS.begin();  // Formats the partition on first use
+#endif
+
+  Config slotA = CONFIG_DEFAULTS;
+  Config slotB = CONFIG_DEFAULTS;
+  uint32_t sequenceA = 0;
+  uint32_t sequenceB = 0;
+  bool validA = readConfigSlot(CONFIG_SLOT_A, slotA, sequenceA);
+  bool validB = readConfigSlot(CONFIG_SLOT_B, slotB, sequenceB);
+
+  if (validA || validB) {
+    configInSlotA = validA && (!validB || sequenceA > sequenceB);
+    config = configInSlotA ? slotA : slotB;
+    configSequence = configInSlotA ? sequenceA : sequenceB;
+    storedConfig = config;
+    LOG_INFO("Config loaded from %s (seq %lu)", configInSlotA ? CONFIG_SLOT_A : CONFIG_SLOT_B,
+             (unsigned long)configSequence);
+  } else if (importLegacyConfig()) {
+    LOG_INFO("Config migrated from EEPROM");
+    saveConfig();
+  } else {
+    config = CONFIG_DEFAULTS;
+    storedConfig = config;
+    LOG_WARN("No valid config, using defaults");
+  }
+}
+
+// Writes `config` to the spare slot if it differs from the stored record.
+bool saveConfig() {
+  if (configSequence > 0 && memcmp(&config, &storedConfig, sizeof(Config)) == 0) {
+    return true;  // Nothing changed, spare the flash
+  }
+
+  const char *path = configInSlotA ? CONFIG_SLOT_B : CONFIG_SLOT_A;
+  ConfigHeader header = configMakeHeader(config, configSequence + 1);
+
+  File file = LittleFS.open(path, "w");
+  if (!file) {
+    LOG_ERROR("Config save failed, cannot open %s", path);
+    return false;
+  }
+  bool ok = file.write((const uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+            file.write((const uint8_t *)&config, sizeof(Config)) == sizeof(Config);
+  file.close();
+  if (!ok) {
+    LOG_ERROR("Config save failed, short write to %s", path);
+    return false;
+  }
+
+  configSequence = header.sequence;
+  configInSlotA = !configInSlotA;
+  storedConfig = config;
+  LOG_INFO("Config saved to %s (seq %lu)", path, (unsigned long)configSequence);
+  return true;
+}
+
+// Re-initialises only the subsystems whose settings differ from `previous`.
+// Pump control is never touched, so the relay keeps its state throughout.
+void applyConfigChanges(const Config &previous) {
+  bool wifiChanged = strcmp(config.wifi_ssid, previous.wifi_ssid) != 0 ||
+                     strcmp(config.wifi_password, previous.wifi_password) != 0;
+  bool mqttChanged = strcmp(config.mqtt_server, previous.mqtt_server) != 0 ||
+                     strcmp(config.mqtt_user, previous.mqtt_user) != 0 ||
+                     strcmp(config.mqtt_password, previous.mqtt_password) != 0 ||
+                     config.mqtt_port != previous.mqtt_port ||
+                     strcmp(config.mqtt_prefix, previous.mqtt_prefix) != 0 ||
+                     strcmp(config.mqtt_group, previous.mqtt_group) != 0 ||
+                     config.mqtt_tls != previous.mqtt_tls ||
+                     strcmp(config.mqtt_fingerprint, previous.mqtt_fingerprint) != 0;
+
+  bool sensorChanged = config.sensor_type != previous.sensor_type ||
+                       config.level_start != previous.level_start ||
+                       config.level_stop != previous.level_stop ||
+                       config.cal_empty != previous.cal_empty ||
+                       config.cal_full != previous.cal_full;
+  bool clockChanged = strcmp(config.ntp_server, previous.ntp_server) != 0 ||
+                      strcmp(config.timezone, previous.timezone) != 0;
+  bool powerChanged = config.power_mode != previous.power_mode ||
+                      config.power_latency_ms != previous.power_latency_ms;
+
+  if (sensorChanged) {
+    setPowerSleeping(false);  // Re-armed for the new sensor by taskPower()
+    postControl(CONTROL_SENSOR_RESTART, 0, 0);
+  }
+  if (config.flow_pulses_per_litre != previous.flow_pulses_per_litre) {
+    postControl(CONTROL_FLOW_RESTART, 0, 0);
+  }
+  if (memcmp(config.schedule, previous.schedule, sizeof(config.schedule)) != 0) {
+    postControl(CONTROL_SCHEDULE_CHANGED, 0, 0);
+  }
+  if (clockChanged) {
+    beginClock();
+  }
+  if (powerChanged) {
+    applyPowerMode();
+  }
+  if (mqttChanged || (powerChanged && client.connected())) {
+    LOG_INFO("MQTT settings changed, reconnecting");  // A new keepalive needs a new session
+    applyMqttConfig();
+  }
+  if (wifiChanged) {
+    LOG_INFO("WiFi settings changed, joining %s", config.wifi_ssid);
+    WiFi.disconnect();
+    joinWiFi();
+  }
+}
+
+// Points the MQTT client at the configured broker and topics and drops any
+// session with the old one; taskMQTT() connects on its next pass.
+void applyMqttConfig() {
+  if (client.connected()) {
+    // A clean disconnect does not fire the last will
+    char availability[MQTT_TOPIC_MAX];
+    snprintf(availability, sizeof(availability), "%s" MQTT_AVAILABILITY, mqttBase);
+    client.publish(availability, "offline", true);
+    client.disconnect();
+  }
+  espClient.stop();  // Half way through an attempt to the old broker
+  tlsClient.stop();
+  buildMqttTopics();
+  mqttConfigured = strlen(config.mqtt_server) > 0 && applyMqttTls();
+  mqttWasConnected = false;
+  mqttBackoff = MQTT_BACKOFF_MIN_MS;
+  mqttNextAttempt = millis();
+  if (mqttConfigured) {
+    client.setServer(config.mqtt_server, config.mqtt_port);
+  }
+  markStatusChanged();
+}
+
+// Selects the plain or TLS transport. A TLS setting that cannot be honoured
+// leaves MQTT off rather than falling back to sending the credentials in
+// the clear.
+bool applyMqttTls() {
+#if !defined(ESP32)
+  tlsSession = BearSSL::Session();  // A session is only valid with the broker that issued it
+#endif
+  tlsProbePending = true;
+  tlsProbeTaken = false;
+  switch (config.mqtt_tls) {
+    case MQTT_TLS_OFF:
+      client.setClient(espClient);
+      return true;
+    case MQTT_TLS_FINGERPRINT:
+#if defined(ESP32)
+      LOG_ERROR("MQTT TLS fingerprint pinning needs the ESP8266 build, MQTT disabled");
+      return false;
+#else
+      if (!tlsClient.setFingerprint(config.mqtt_fingerprint)) {
+        LOG_ERROR("MQTT TLS fingerprint \"%s\" is not 20 hex bytes, MQTT disabled", config.mqtt_fingerprint);
+        return false;
+      }
+      break;
+#endif
+    case MQTT_TLS_CA:
+#if MQTT_CA_ENABLED && defined(ESP32)
+      tlsClient.setCACert(MQTT_CA_CERT);
+      break;
+#elif MQTT_CA_ENABLED
+      tlsClient.setTrustAnchors(&tlsTrustAnchors);
+      break;
+#else
+      LOG_ERROR("MQTT TLS needs a CA but none is built in (mqtt_ca.h), MQTT disabled");
+      return false;
+#endif
+    default:
+      LOG_ERROR("Unknown MQTT TLS mode %u, MQTT disabled", config.mqtt_tls);
+      return false;
+  }
+  client.setClient(tlsClient);
+  LOG_INFO("MQTT over TLS (%s)", MQTT_TLS_NAMES[config.mqtt_tls]);
+  return true;
+}
+
+// Fills deviceId and the topic bases from the chip ID and config. A prefix
+// or group that would not make a valid topic falls back to the default and
+// no group.
+void buildMqttTopics() {
+  snprintf(deviceId, sizeof(deviceId), "wt-%06lx", (unsigned long)chipId());
+  if (!mqttTopicNameValid(config.mqtt_prefix, true)) {
+    LOG_WARN("MQTT prefix \"%s\" is not a valid topic, using %s", config.mqtt_prefix, CONFIG_DEFAULTS.mqtt_prefix);
+    strcpy(config.mqtt_prefix, CONFIG_DEFAULTS.mqtt_prefix);
+  }
+  if (config.mqtt_group[0] != '\0' && !mqttTopicNameValid(config.mqtt_group, false)) {
+    LOG_WARN("MQTT group \"%s\" is not a valid topic level, ignored", config.mqtt_group);
+    config.mqtt_group[0] = '\0';
+  }
+  snprintf(mqttBase, sizeof(mqttBase), "%s/%s/", config.mqtt_prefix, deviceId);
+  snprintf(mqttBroadcastBase, sizeof(mqttBroadcastBase), "%s/" MQTT_BROADCAST "/", config.mqtt_prefix);
+  mqttGroupBase[0] = '\0';
+  if (config.mqtt_group[0] != '\0') {
+    snprintf(mqttGroupBase, sizeof(mqttGroupBase), "%s/group/%s/", config.mqtt_prefix, config.mqtt_group);
+  }
+  LOG_INFO("MQTT topics under %s%s%s", mqttBase, mqttGroupBase[0] ? ", " : "", mqttGroupBase);
+}
+
+// The last three bytes of the station MAC, as the ESP8266 SDK's chip ID
+// is, so a unit keeps its device ID whichever chip it runs on.
+uint32_t chipId() {
+#if defined(ESP32)
+  uint64_t mac = ESP.getEfuseMac();  // MAC byte 0 in the low byte
+  return (uint32_t)((mac >> 24) & 0xFF) << 16 | (uint32_t)((mac >> 32) & 0xFF) << 8 | (uint32_t)((mac >> 40) & 0xFF);
+#else
+  return ESP.getChipId();
+#endif
+}
+
+uint32_t hardwareRandom() {
+#if defined(ESP32)
+  return esp_random();
+#else
+  return ESP.random();
+#endif
+}
+
+// Reads one slot into `out`, which must hold the defaults. Returns false for
+// a missing, foreign or corrupt record and leaves `out` alone.
+bool readConfigSlot(const char *path, Config &out, uint32_t &sequence) {
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    return false;
+  }
+  bool ok = configReadRecord(readConfigFile, &file, out, sequence);
+  file.close();
+
+  if (!ok) {
+    LOG_WARN("Config slot %s is invalid", path);
+  }
+  return ok;
+}
+
+size_t readConfigFile(void *context, uint8_t *buffer, size_t length) {
+  return ((File *)context)->read(buffer, length);
+}
+
+// Reads the fixed-offset layout older firmware wrote with EEPROM.put(). A
+// blank or never-written chip reads back as 0xFF, which fails the checks.
+bool importLegacyConfig() {
+  Config legacy = CONFIG_DEFAULTS;
+
+  EEPROM.begin(EEPROM_SIZE);
+  EEPROM.get(WIFI_SSID_ADDR, legacy.wifi_ssid);
+  EEPROM.get(WIFI_PASS_ADDR, legacy.wifi_password);
+  EEPROM.get(MQTT_ADDR, legacy.mqtt_server);
+  EEPROM.get(MQTT_ADDR + 40, legacy.mqtt_user);
+  EEPROM.get(MQTT_ADDR + 60, legacy.mqtt_password);
+  EEPROM.get(MQTT_ADDR + 80, legacy.mqtt_port);
+  EEPROM.end();
+
+  if (!configLegacyValid(legacy)) {
+    return false;
+  }
+
+  config = legacy;
+  return true;
+}
+
+// Continues the page sequence and boot counter from the newest page found.
+void beginEventLog() {
+  uint32_t nextSequence = 0;
+  uint16_t lastBoot = 0;
+  for (uint32_t slot = 0; slot < EVENT_LOG_PAGES; slot++) {
+    EventPageHeader header;
+    if (readEventPage(slot, &header, sizeof(header)) && header.sequence + 1 > nextSequence) {
+      nextSequence = header.sequence + 1;
+      lastBoot = header.boot;
+    }
+  }
+
+  startEventPage(nextSequence, lastBoot + 1, millis() / 1000);
+  eventLogReady = true;
+  logEvent(EVENT_BOOT, 0);
+}
+
+void eventPagePath(uint32_t slot, char *path, size_t size) {
+  snprintf(path, size, "/ev%02lu.bin", (unsigned long)slot);
+}
+
+// Reads the first `size` bytes of a page slot. False if missing or not a page.
+bool readEventPage(uint32_t slot, void *out, size_t size) {
+  char path[16];
+  eventPagePath(slot, path, sizeof(path));
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    return false;
+  }
+  bool ok = file.read((uint8_t *)out, size) == size && ((EventPageHeader *)out)->magic == EVENT_PAGE_MAGIC;
+  file.close();
+  return ok;
+}
+
+void startEventPage(uint32_t sequence, uint16_t boot, uint32_t baseTime) {
+  memset(&eventPage, 0xFF, sizeof(eventPage));
+  eventPage.header.magic = EVENT_PAGE_MAGIC;
+  eventPage.header.boot = boot;
+  eventPage.header.sequence = sequence;
+  eventPage.header.baseTime = baseTime;
+  eventPage.header.count = 0;
+  eventLastTime = baseTime;
+}
+
+// Queues a record with the sensor/pump snapshot of `channel` for
+// taskEventLog(). Only the control side logs events.
+void logEvent(EventType type, size_t channel) {
+  logEventValue(type, channel, 0);
+}
+
+// As logEvent(), for a type that carries a value (see eventHasValue()).
+void logEventValue(EventType type, size_t channel, uint32_t value) {
+  const Channel &ch = channels[channel];
+  EventEntry entry;
+  entry.time = millis() / 1000;
+  entry.type = type | (channel << 4);
+  entry.bits = (ch.low ? 0x01 : 0) | (ch.high ? 0x02 : 0) | (ch.pump.on ? 0x04 : 0) |
+               (ch.overrideMode ? 0x08 : 0) | (ch.pump.state << 4);
+  entry.value = value;
+  if (!spscPush(eventQueue, entry)) {
+    eventsDropped++;
+    LOG_WARN("Event queue full, %s dropped", EVENT_TYPE_NAMES[type]);
+  }
+}
+
+bool eventHasValue(uint8_t type) {
+  return type == EVENT_FILL_VOLUME;
+}
+
+// Packs a queued event into the page, with its continuation slot for a type
+// that carries a value. A full page, or a gap too long for the 16-bit
+// delta, is written out and a new page started.
+void appendEventRecord(const EventEntry &entry) {
+  uint8_t slots = eventHasValue(entry.type & EVENT_TYPE_MASK) ? 2 : 1;
+  if (eventPage.header.count + slots > EVENT_PAGE_RECORDS || entry.time - eventLastTime > UINT16_MAX) {
+    flushEventPage();
+    startEventPage(eventPage.header.sequence + 1, eventPage.header.boot, entry.time);
+  }
+
+  EventRecord *record = &eventPage.records[eventPage.header.count];
+  record->delta = entry.time - eventLastTime;
+  record->type = entry.type;
+  record->bits = entry.bits;
+  if (slots == 2) {
+    memcpy(record + 1, &entry.value, sizeof(entry.value));
+  }
+  eventPage.header.count += slots;  // Last, so a handler copying the page never sees half a record
+  eventLastTime = entry.time;
+  eventPageDirty = true;
+}
+
+// Writes the page being filled to its slot file.
+void flushEventPage() {
+  if (!eventPageDirty) {
+    return;
+  }
+
+  char path[16];
+  eventPagePath(eventPage.header.sequence % EVENT_LOG_PAGES, path, sizeof(path));
+  File file = LittleFS.open(path, "w");
+  if (!file) {
+    LOG_ERROR("Event log flush failed, cannot open %s", path);
+    return;
+  }
+  file.write((const uint8_t *)&eventPage, sizeof(eventPage));
+  file.close();
+
+  eventPageDirty = false;
+  eventFlushedAt = millis();
+}
+
+void taskEventLog() {
+  EventEntry entry;
+  while (eventLogReady && spscPop(eventQueue, entry)) {
+    appendEventRecord(entry);
+  }
+  if (eventPageDirty && millis() - eventFlushedAt >= EVENT_FLUSH_MS) {
+    flushEventPage();
+  }
+}
+
+// Copies page `sequence` into `page`: the page being filled comes from RAM,
+// older ones from flash. False if it was overwritten or never written.
+bool loadEventPage(uint32_t sequence, EventPage &page) {
+  if (sequence == eventPage.header.sequence) {
+    page = eventPage;
+    return true;
+  }
+  return readEventPage(sequence % EVENT_LOG_PAGES, &page, sizeof(page)) &&
+         page.header.sequence == sequence && page.header.count <= EVENT_PAGE_RECORDS;
+}
+
+EventCursor eventCursorAtOldest() {
+  uint32_t newest = eventPage.header.sequence;
+  EventCursor cursor = {};
+  cursor.sequence = newest >= EVENT_LOG_PAGES - 1 ? newest - (EVENT_LOG_PAGES - 1) : 0;
+  return cursor;
+}
+
+// Loads the next page that can still be read. False past the newest page.
+bool nextEventPage(EventCursor &cursor) {
+  if (cursor.loaded) {
+    cursor.sequence++;
+  }
+  for (; cursor.sequence <= eventPage.header.sequence; cursor.sequence++) {
+    if (loadEventPage(cursor.sequence, cursor.page)) {
+      cursor.loaded = true;
+      cursor.record = 0;
+      cursor.time = cursor.page.header.baseTime;
+      return true;
+    }
+  }
+  cursor.loaded = false;
+  return false;
+}
+
+// Next record, with its absolute uptime in cursor.time and its value in
+// cursor.value. Null at the end.
+const EventRecord *nextEventRecord(EventCursor &cursor) {
+  while (!cursor.loaded || cursor.record >= cursor.page.header.count) {
+    if (!nextEventPage(cursor)) {
+      return nullptr;
+    }
+  }
+  const EventRecord *record = &cursor.page.records[cursor.record++];
+  cursor.time += record->delta;
+  cursor.value = 0;
+  if (eventHasValue(record->type & EVENT_TYPE_MASK) && cursor.record < cursor.page.header.count) {
+    memcpy(&cursor.value, &cursor.page.records[cursor.record++], sizeof(cursor.value));
+  }
+  return record;
+}
+
+// Chunked CSV, one line per record with the delta timestamps expanded.
+void handleEventsCsv(AsyncWebServerRequest *request) {
+  EventCursor cursor = eventCursorAtOldest();
+  bool headerSent = false;
+
+  sendStream(request, "text/csv", [cursor, headerSent](uint8_t *buffer, size_t size) mutable -> size_t {
+    char *line = (char *)buffer;
+    if (!headerSent) {
+      headerSent = true;
+      return snprintf(line, size, "boot,uptime_s,event,low,high,pump,override,state,tank,volume_ml\r\n");
+    }
+    const EventRecord *record = nextEventRecord(cursor);
+    if (!record) {
+      return 0;
+    }
+    uint8_t type = record->type & EVENT_TYPE_MASK;
+    uint8_t channel = record->type >> 4;
+    char value[12] = "";
+    if (eventHasValue(type)) {
+      snprintf(value, sizeof(value), "%lu", (unsigned long)cursor.value);
+    }
+    return snprintf(line, size, "%u,%lu,%s,%u,%u,%u,%u,%s,%s,%s\r\n", cursor.page.header.boot, (unsigned long)cursor.time,
+                    type < sizeof(EVENT_TYPE_NAMES) / sizeof(EVENT_TYPE_NAMES[0]) ? EVENT_TYPE_NAMES[type] : "?",
+                    record->bits & 0x01, (record->bits >> 1) & 0x01, (record->bits >> 2) & 0x01, (record->bits >> 3) & 0x01,
+                    (record->bits >> 4) <= PUMP_INTERLOCK ? PUMP_STATE_NAMES[record->bits >> 4] : "?",
+                    channel < CHANNEL_COUNT ? channels[channel].id : "?", value);
+  });
+}
+
+// Raw pages as stored (see EventPage), oldest first.
+void handleEventsBinary(AsyncWebServerRequest *request) {
+  EventCursor cursor = eventCursorAtOldest();
+
+  sendStream(request, "application/octet-stream", [cursor](uint8_t *buffer, size_t size) mutable -> size_t {
+    if (!nextEventPage(cursor)) {
+      return 0;
+    }
+    size_t n = min(size, sizeof(cursor.page));
+    memcpy(buffer, &cursor.page, n);
+    return n;
+  });
+}
+
+// Counts the boot of an image still on trial.
+void beginOta() {
+  File file = LittleFS.open(OTA_STATE_FILE, "r");
+  bool ok = file && file.read((uint8_t *)&otaRecord, sizeof(otaRecord)) == sizeof(otaRecord) &&
+            otaRecord.magic == OTA_MAGIC;
+  if (file) {
+    file.close();
+  }
+  if (!ok) {
+    otaRecord = {};
+    return;
+  }
+  if (otaRecord.trial) {
+    otaRecord.boots++;
+    writeOtaRecord(otaRecord);
+    LOG_INFO("Firmware %s on trial, boot %u", FIRMWARE_VERSION, otaRecord.boots);
+  }
+}
+
+bool writeOtaRecord(const OtaRecord &record) {
+  File file = LittleFS.open(OTA_STATE_FILE, "w");
+  if (!file) {
+    LOG_ERROR("Cannot write %s", OTA_STATE_FILE);
+    return false;
+  }
+  bool ok = file.write((const uint8_t *)&record, sizeof(record)) == sizeof(record);
+  file.close();
+  return ok;
+}
+
+// Payload is the manifest URL. The work happens in taskOta().
+bool onOtaCommand(const byte *payload, unsigned int length) {
+  if (!OTA_ENABLED) {
+    LOG_WARN("OTA request ignored, no signing key built in");
+    return false;
+  }
+  if (otaState != OTA_IDLE || length == 0 || length >= sizeof(otaManifestUrl)) {
+    LOG_WARN("OTA request ignored (%s)", otaState != OTA_IDLE ? "update in progress" : "bad URL");
+    return false;
+  }
+  memcpy(otaManifestUrl, payload, length);
+  otaManifestUrl[length] = '\0';
+  otaState = OTA_CHECK;
+  return true;
+}
+
+void taskOta() {
+  if (otaRecord.trial && otaState == OTA_IDLE) {
+    checkOtaHealth();
+  }
+
+  switch (otaState) {
+    case OTA_IDLE:
+      break;
+    case OTA_CHECK:
+      otaState = OTA_IDLE;
+      checkOtaManifest();
+      break;
+    case OTA_DOWNLOAD:
+      downloadOtaChunk();
+      break;
+    case OTA_RESTART:
+      if (!anyPumpOn()) {
+        LOG_INFO("Restarting into new firmware");
+        flushEventPage();
+        ESP.restart();
+      }
+      break;
+  }
+}
+
+// Keeps an image on trial once it has proved itself, rolls it back if it
+// crash-loops or cannot reach the broker in time.
+void checkOtaHealth() {
+  if (client.connected() && millis() >= OTA_HEALTH_MIN_MS) {
+    otaRecord.trial = 0;
+    otaRecord.boots = 0;
+    writeOtaRecord(otaRecord);
+    LOG_INFO("Firmware %s confirmed", FIRMWARE_VERSION);
+    return;
+  }
+  if (otaRecord.boots <= OTA_MAX_TRIAL_BOOTS && millis() < OTA_HEALTH_TIMEOUT_MS) {
+    return;
+  }
+  if (WiFi.status() != WL_CONNECTED || (long)(millis() - otaRetryAt) < 0) {
+    return;
+  }
+
+  if (otaRecord.rollbackUrl[0] == '\0') {
+    LOG_ERROR("Firmware %s failed its health check, no rollback image", FIRMWARE_VERSION);
+    otaRecord.trial = 0;
+    writeOtaRecord(otaRecord);
+    return;
+  }
+
+  LOG_ERROR("Firmware %s failed its health check, rolling back", FIRMWARE_VERSION);
+  otaNextRecord = {};
+  otaNextRecord.magic = OTA_MAGIC;
+  if (!startOtaDownload(otaRecord.rollbackUrl, otaRecord.rollbackMd5, otaRecord.rollbackSha256)) {
+    otaRetryAt = millis() + OTA_RETRY_MS;
+  }
+}
+
+// Fetches and verifies the manifest, then starts the download if it names
+// a newer version. Anything else is refused, so replaying an old signed
+// manifest cannot downgrade the unit; rollback images come only from the
+// OtaRecord. The manifest is small, so this one fetch blocks, for at most
+// OTA_HTTP_TIMEOUT_MS per step.
+void checkOtaManifest() {
+#if OTA_ENABLED
+  std::unique_ptr<char[]> text(new char[OTA_MANIFEST_MAX]);
+  size_t length = 0;
+
+  otaHttp.setTimeout(OTA_HTTP_TIMEOUT_MS);
+  if (otaHttp.begin(otaClient, otaManifestUrl)) {
+    int code = otaHttp.GET();
+    int size = otaHttp.getSize();
+    if (code == HTTP_CODE_OK && size > 0 && size < OTA_MANIFEST_MAX) {
+      length = otaHttp.getStream().readBytes(text.get(), size);
+    } else {
+      LOG_WARN("OTA manifest fetch failed: HTTP %d, %d bytes", code, size);
+    }
+    otaHttp.end();
+  }
+  text[length] = '\0';
+
+  OtaManifest manifest;
+  if (length == 0 || !otaParseManifest(text.get(), manifest) || !verifyOtaSignature(text.get(), manifest)) {
+    LOG_WARN("OTA manifest from %s rejected", otaManifestUrl);
+    return;
+  }
+  if (!otaVersionNewer(manifest.version, FIRMWARE_VERSION)) {
+    LOG_INFO("Firmware %s is current, manifest offers %s", FIRMWARE_VERSION, manifest.version);
+    return;
+  }
+
+  otaNextRecord = {};
+  otaNextRecord.magic = OTA_MAGIC;
+  otaNextRecord.trial = 1;
+  strcpy(otaNextRecord.version, manifest.version);
+  strcpy(otaNextRecord.rollbackUrl, manifest.rollbackUrl);
+  strcpy(otaNextRecord.rollbackMd5, manifest.rollbackMd5);
+  strcpy(otaNextRecord.rollbackSha256, manifest.rollbackSha256);
+  LOG_INFO("Updating %s -> %s", FIRMWARE_VERSION, manifest.version);
+  startOtaDownload(manifest.url, manifest.md5, manifest.sha256);
+#endif
+}
+
+#if OTA_ENABLED
+// Checks the manifest signature against the built-in public key.
+bool verifyOtaSignature(const char *text, const OtaManifest &manifest) {
+  uint8_t signature[512];
+  size_t length = hexDecode(manifest.signature, manifest.signatureLength, signature, sizeof(signature));
+  if (length == 0) {
+    return false;
+  }
+
+#if defined(ESP32)
+  uint8_t digest[32];
+  mbedtls_pk_context key;
+  mbedtls_pk_init(&key);
+  bool ok = mbedtls_pk_parse_public_key(&key, (const unsigned char *)OTA_PUBLIC_KEY, strlen(OTA_PUBLIC_KEY) + 1) == 0 &&
+            mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), (const unsigned char *)text,
+                       manifest.signedLength, digest) == 0 &&
+            mbedtls_pk_verify(&key, MBEDTLS_MD_SHA256, digest, sizeof(digest), signature, length) == 0;
+  mbedtls_pk_free(&key);
+  return ok;
+#else
+  BearSSL::PublicKey key(OTA_PUBLIC_KEY);
+  BearSSL::HashSHA256 hash;
+  hash.begin();
+  hash.add(text, manifest.signedLength);
+  hash.end();
+  BearSSL::SigningVerifier verifier(&key);
+  return verifier.verify(&hash, signature, length);
+#endif
+}
+#endif
+
+String otaErrorString() {
+#if defined(ESP32)
+  return Update.errorString();
+#else
+  return Update.getErrorString();
+#endif
+}
+
+// Opens the image download and the flash update. False, with nothing
+// started, if either fails. The GET blocks the network task until the
+// response headers are in, for at most OTA_HTTP_TIMEOUT_MS per step
+// (connect, then headers); only the body is streamed by downloadOtaChunk().
+bool startOtaDownload(const char *url, const char *md5, const char *sha256) {
+  if (hexDecode(sha256, strlen(sha256), otaSha256, sizeof(otaSha256)) != sizeof(otaSha256)) {
+    LOG_WARN("OTA download refused, no SHA-256 for %s", url);
+    return false;
+  }
+  otaHttp.setTimeout(OTA_HTTP_TIMEOUT_MS);
+  if (!otaHttp.begin(otaClient, url)) {
+    LOG_WARN("OTA download failed, bad URL %s", url);
+    return false;
+  }
+  int code = otaHttp.GET();
+  int size = otaHttp.getSize();
+  if (code != HTTP_CODE_OK || size <= 0) {
+    LOG_WARN("OTA download failed: HTTP %d, %d bytes", code, size);
+    otaHttp.end();
+    return false;
+  }
+  if (!Update.begin(size) || !Update.setMD5(md5)) {
+    LOG_ERROR("OTA cannot start: %s", otaErrorString().c_str());
+    Update.end();
+    otaHttp.end();
+    return false;
+  }
+
+  otaHashBegin();
+  otaRemaining = size;
+  otaProgressAt = millis();
+  otaState = OTA_DOWNLOAD;
+  LOG_INFO("OTA downloading %d bytes", size);
+  return true;
+}
+
+void otaHashBegin() {
+#if defined(ESP32)
+  mbedtls_md_free(&otaHash);
+  mbedtls_md_init(&otaHash);
+  mbedtls_md_setup(&otaHash, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0);
+  mbedtls_md_starts(&otaHash);
+#else
+  otaHash.begin();
+#endif
+}
+
+void otaHashAdd(const uint8_t *data, size_t length) {
+#if defined(ESP32)
+  mbedtls_md_update(&otaHash, data, length);
+#else
+  otaHash.add(data, length);
+#endif
+}
+
+// Finishes the digest and compares it with the manifest's.
+bool otaHashMatches() {
+  uint8_t digest[32];
+#if defined(ESP32)
+  bool ok = mbedtls_md_finish(&otaHash, digest) == 0;
+  mbedtls_md_free(&otaHash);
+#else
+  otaHash.end();
+  memcpy(digest, otaHash.hash(), sizeof(digest));
+  bool ok = true;
+#endif
+  return ok && memcmp(digest, otaSha256, sizeof(digest)) == 0;
+}
+
+// Moves at most OTA_CHUNK_SIZE bytes from the socket to flash. The SHA-256
+// is checked before the last chunk is written: once every byte is in,
+// Update.end() would commit the image rather than discard it.
+void downloadOtaChunk() {
+  WiFiClient &stream = otaHttp.getStream();
+  size_t available = stream.available();
+
+  if (available > 0) {
+    uint8_t chunk[OTA_CHUNK_SIZE];
+    size_t n = stream.readBytes(chunk, min(available, min(otaRemaining, sizeof(chunk))));
+    otaHashAdd(chunk, n);
+    if (n == otaRemaining && !otaHashMatches()) {
+      abortOta("SHA-256 mismatch");
+      return;
+    }
+    if (Update.write(chunk, n) != n) {
+      abortOta("flash write failed");
+      return;
+    }
+    otaRemaining -= n;
+    otaProgressAt = millis();
+  } else if (millis() - otaProgressAt >= OTA_STALL_MS) {
+    abortOta("download stalled");
+    return;
+  }
+
+  if (otaRemaining > 0) {
+    return;
+  }
+
+  otaHttp.end();
+  if (!Update.end()) {
+    LOG_ERROR("OTA image rejected: %s", otaErrorString().c_str());
+    otaState = OTA_IDLE;
+    otaRetryAt = millis() + OTA_RETRY_MS;
+    return;
+  }
+  writeOtaRecord(otaNextRecord);
+  otaState = OTA_RESTART;
+  LOG_INFO("OTA image verified, restarting once the pump is off");
+}
+
+void abortOta(const char *reason) {
+  LOG_ERROR("OTA aborted: %s", reason);
+  Update.end();  // Not finished, so this discards the partial image
+  otaHttp.end();
+  otaState = OTA_IDLE;
+  otaRetryAt = millis() + OTA_RETRY_MS;
+}
+
+// Starts SNTP with the configured server and time zone. The clock is set
+// in the background once WiFi is up; taskSchedule() waits for it.
+void beginClock() {
+#if defined(ESP32)
+  configTzTime(config.timezone, config.ntp_server);
+#else
+  configTime(config.timezone, config.ntp_server);
+#endif
+}
+
+// Re-evaluates the schedule against local time. The pump is only asked to
+// reconsider when the window in force changes.
+void taskSchedule() {
+  time_t now = time(nullptr);
+  ScheduleAction action = SCHEDULE_NONE;
+
+  if (now >= CLOCK_VALID_AFTER) {
+    struct tm local;
+    localtime_r(&now, &local);
+    if (!clockSet) {
+      clockSet = true;
+      LOG_INFO("Clock set: %04d-%02d-%02d %02d:%02d local time", local.tm_year + 1900, local.tm_mon + 1,
+               local.tm_mday, local.tm_hour, local.tm_min);
+    }
+    action = scheduleActionAt(controlSettings.schedule, SCHEDULE_RULES, local.tm_wday, local.tm_hour * 60 + local.tm_min);
+  }
+
+  if (action == scheduleAction) {
+    return;
+  }
+  LOG_INFO("Schedule window: %s -> %s", SCHEDULE_ACTION_NAMES[scheduleAction], SCHEDULE_ACTION_NAMES[action]);
+  scheduleAction = action;
+  for (Channel &ch : channels) {
+    ch.eventPending = true;
+  }
+  markStatusChanged();
+  logEvent(EVENT_SCHEDULE, 0);
+}
+
+// Payload "<n> <rule>" replaces rule n (0-based), e.g. "0 mon-fri 23:00-06:30
+// topup" or "2 off". Saved like a /save from the setup page.
+bool onScheduleCommand(const byte *payload, unsigned int length) {
+  if (length < 3 || payload[0] < '0' || payload[0] >= '0' + SCHEDULE_RULES || payload[1] != ' ') {
+    LOG_WARN("Schedule command ignored, expected \"<n> <rule>\"");
+    return false;
+  }
+  int index = payload[0] - '0';
+  char rule[SCHEDULE_RULE_TEXT_MAX];
+  CONFIG_LOCK();
+  if (!configSavePending) {
+    pendingConfig = config;
+  }
+  bool ok = scheduleParseRule((const char *)payload + 2, length - 2, pendingConfig.schedule[index]);
+  if (ok) {
+    scheduleFormatRule(pendingConfig.schedule[index], rule, sizeof(rule));
+    configSavePending = true;
+  }
+  CONFIG_UNLOCK();
+  if (!ok) {
+    LOG_WARN("Schedule rule %d not understood", index);
+    return false;
+  }
+  LOG_INFO("Schedule rule %d: %s", index, rule);
+  return true;
+}
+
+#if SOAK_TEST
+void resetSoakWindow() {
+  soakWindow = SoakSample();
+  soakWindow.heapMin = UINT32_MAX;
+  soakWindow.blockMin = UINT32_MAX;
+  soakWindowStart = millis();
+}
+
+void taskSoak() {
+  if (soakWindowStart == 0) {
+    resetSoakWindow();
+  }
+  soakWindow.heapMin = min(soakWindow.heapMin, ESP.getFreeHeap());
+  soakWindow.blockMin = min(soakWindow.blockMin, heapMaxBlock());
+  soakWindow.fragMax = max(soakWindow.fragMax, heapFragmentation());
+  if (millis() - soakWindowStart < SOAK_WINDOW_MS) {
+    return;
+  }
+
+  soakWindow.uptime = millis() / 1000;
+  soakWindow.wifiReconnects = wifiReconnects;
+  soakWindow.mqttConnects = mqttConnects;
+  soakWindow.mqttFailures = mqttConnectFailures;
+  soakSamples[soakCount % SOAK_SAMPLES] = soakWindow;
+  soakCount++;
+  resetSoakWindow();
+}
+
+// Every recorded window, oldest first, for tools/soak.py. Streamed one
+// sample per piece; the full report would otherwise be buffered whole, some
+// 30 kB at SOAK_SAMPLES. Windows completed while it is going out are left
+// for the next report. "dropped" comes last, so it can also count windows
+// overwritten before their turn to go out.
+void handleSoakReport(AsyncWebServerRequest *request) {
+  uint32_t dropped = soakCount > SOAK_SAMPLES ? soakCount - SOAK_SAMPLES : 0;
+  uint32_t next = dropped;
+  uint32_t end = soakCount;
+  bool headerSent = false;
+  bool sampleSent = false;
+  bool footerSent = false;
+
+  sendStream(request, "application/json",
+             [dropped, next, end, headerSent, sampleSent, footerSent](uint8_t *buffer, size_t size) mutable -> size_t {
+    char *json = (char *)buffer;
+    if (!headerSent) {
+      headerSent = true;
+      return snprintf(json, size, "{\"fw\":\"%s\",\"device\":\"%s\",\"uptime\":%lu,\"windowMs\":%lu,\"samples\":[",
+                      FIRMWARE_VERSION, deviceId, millis() / 1000, SOAK_WINDOW_MS);
+    }
+    if (next + SOAK_SAMPLES < soakCount) {
+      uint32_t oldest = soakCount - SOAK_SAMPLES;  // Overwritten while waiting for the client
+      dropped += (oldest < end ? oldest : end) - (next < end ? next : end);
+      next = oldest;
+    }
+    if (next < end) {
+      const SoakSample &sample = soakSamples[next++ % SOAK_SAMPLES];
+      bool comma = sampleSent;
+      sampleSent = true;
+      return snprintf(json, size, "%s{\"t\":%lu,\"heapMin\":%lu,\"blockMin\":%lu,\"fragMax\":%u,\"loopMaxUs\":%lu,"
+                      "\"wifiReconnects\":%u,\"mqttConnects\":%u,\"mqttFailures\":%u}",
+                      comma ? "," : "",
+                      (unsigned long)sample.uptime, (unsigned long)sample.heapMin, (unsigned long)sample.blockMin,
+                      sample.fragMax, (unsigned long)sample.loopMaxUs, sample.wifiReconnects, sample.mqttConnects,
+                      sample.mqttFailures);
+    }
+    if (!footerSent) {
+      footerSent = true;
+      return snprintf(json, size, "],\"dropped\":%lu}", (unsigned long)dropped);
+    }
+    return 0;
+  });
 }
+#endif
@@ -0,0 +1,119 @@
+// Board profiles: which GPIO each signal is wired to and which way the
+// relay and LED are driven, for every board revision we build for. Pick
+// one at build time with -DBOARD_PROFILE=<name> (the PlatformIO envs in
+// platformio.ini do this); BOARD_NODEMCU_V2 is the default, the original
+// wiring, or BOARD_ESP32_DEVKIT on the ESP32. To support a new board, add a
+// profile here and an env there, instead of editing pin numbers in the
+// sketch.
+#pragma once
+
+#include <stdint.h>
+
+#define BOARD_NO_PIN 0xFF  // Signal not wired on this board
+
+enum BoardChip : uint8_t { CHIP_ESP8266, CHIP_ESP32 };
+
+#if defined(ESP32)
+#define BOARD_BUILD_CHIP CHIP_ESP32
+#else
+#define BOARD_BUILD_CHIP CHIP_ESP8266
+#endif
+
+struct BoardProfile {
+  const char *name;  // Reported in the health frame
+  BoardChip chip;
+  uint8_t lowSensorPin;
+  uint8_t highSensorPin;
+  uint8_t relayPin;
+  uint8_t roofLowSensorPin;   // Second tank channel, BOARD_NO_PIN without one
+  uint8_t roofHighSensorPin;
+  uint8_t roofRelayPin;
+  uint8_t ultrasonicTrigPin;  // May be shared with the second channel
+  uint8_t ultrasonicEchoPin;
+  uint8_t flowMeterPin;
+  uint8_t ledPin;
+  bool relayActiveHigh;       // Relay module closes on a HIGH input
+  bool ledActiveLow;
+};
+
+// NodeMCU v2 with an active-high relay module: D2/D1 floats, relay on D5,
+// roof tank on D6/D7 and D0, flow meter on RX
+constexpr BoardProfile BOARD_NODEMCU_V2 = {
+  "nodemcuv2", CHIP_ESP8266, 4, 5, 14, 12, 13, 16, 12, 13, 3, 2, true, true
+};
+
+// Same wiring with the common optocoupled relay boards, which close on LOW
+constexpr BoardProfile BOARD_NODEMCU_V2_ACTIVE_LOW = {
+  "nodemcuv2-active-low", CHIP_ESP8266, 4, 5, 14, 12, 13, 16, 12, 13, 3, 2, false, true
+};
+
+// Wemos D1 mini with the relay shield, which takes D1: the high float
+// moves to D5
+constexpr BoardProfile BOARD_D1_MINI = {
+  "d1_mini", CHIP_ESP8266, 4, 14, 5, 12, 13, 16, 12, 13, 3, 2, true, true
+};
+
+// ESP32 DevKitC / DOIT devkit: floats on GPIO32/33, relay on 26, roof tank
+// on 25/14 and 27, ultrasonic on 18/19 of its own, flow meter on 23 and the
+// on-board LED on 2. Keeps clear of the strapping pins 0, 12 and 15, and of
+// 14 for a relay since it toggles at boot.
+constexpr BoardProfile BOARD_ESP32_DEVKIT = {
+  "esp32dev", CHIP_ESP32, 32, 33, 26, 25, 14, 27, 18, 19, 23, 2, true, false
+};
+
+// True if `pin` is a GPIO the sketch may use on `chip`: GPIO6-11 carry the
+// flash on both; the ESP32 goes up to 39.
+constexpr bool boardPinUsable(BoardChip chip, uint8_t pin) {
+  return pin == BOARD_NO_PIN || pin < 6 || (pin > 11 && pin <= (chip == CHIP_ESP32 ? 39 : 16));
+}
+
+// True if `pin` can drive an output: GPIO34-39 on the ESP32 are input-only.
+constexpr bool boardPinOutput(BoardChip chip, uint8_t pin) {
+  return boardPinUsable(chip, pin) && (chip != CHIP_ESP32 || pin == BOARD_NO_PIN || pin < 34);
+}
+
+// True if the ultrasonic sensor's pins double as the second channel's float
+// pins, so the two can't be used together.
+constexpr bool boardUltrasonicShared(const BoardProfile &b) {
+  return b.ultrasonicTrigPin == b.roofLowSensorPin || b.ultrasonicTrigPin == b.roofHighSensorPin ||
+         b.ultrasonicEchoPin == b.roofLowSensorPin || b.ultrasonicEchoPin == b.roofHighSensorPin;
+}
+
+// True if every pin is usable, the outputs can drive, and the main tank's
+// signals, the flow meter and the LED each have a pin of their own.
+constexpr bool boardProfileValid(const BoardProfile &b) {
+  const uint8_t own[] = { b.lowSensorPin, b.highSensorPin, b.relayPin, b.flowMeterPin, b.ledPin };
+  const uint8_t all[] = { b.lowSensorPin, b.highSensorPin, b.relayPin, b.roofLowSensorPin, b.roofHighSensorPin,
+                          b.roofRelayPin, b.ultrasonicTrigPin, b.ultrasonicEchoPin, b.flowMeterPin, b.ledPin };
+  const uint8_t outputs[] = { b.relayPin, b.roofRelayPin, b.ultrasonicTrigPin, b.ledPin };
+  for (uint8_t pin : all) {
+    if (!boardPinUsable(b.chip, pin)) {
+      return false;
+    }
+  }
+  for (uint8_t pin : outputs) {
+    if (!boardPinOutput(b.chip, pin)) {
+      return false;
+    }
+  }
+  for (unsigned i = 0; i < sizeof(own); i++) {
+    for (unsigned j = i + 1; j < sizeof(own); j++) {
+      if (own[i] == own[j]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+#ifndef BOARD_PROFILE
+#if defined(ESP32)
+#define BOARD_PROFILE BOARD_ESP32_DEVKIT
+#else
+#define BOARD_PROFILE BOARD_NODEMCU_V2
+#endif
+#endif
+
+constexpr const BoardProfile &BOARD = BOARD_PROFILE;
+static_assert(BOARD.chip == BOARD_BUILD_CHIP, "BOARD_PROFILE is for the other chip");
+static_assert(boardProfileValid(BOARD), "BOARD_PROFILE uses a flash pin or gives two signals one pin");
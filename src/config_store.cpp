@@ -0,0 +1,78 @@
+#include "config_store.h"
+
+const Config CONFIG_DEFAULTS = { "", "", "", "", "", 1883, 0, 20, 95, 0, 0, 1023, 0, 0, 1000,
+                                "pool.ntp.org", "UTC0", {}, "waterpump", "", 0, 0, "", 0, 0 };
+
+ConfigHeader configMakeHeader(const Config &config, uint32_t sequence) {
+  ConfigHeader header;
+  header.magic = CONFIG_MAGIC;
+  header.version = CONFIG_VERSION;
+  header.length = sizeof(Config);
+  header.sequence = sequence;
+  header.crc = ~crc32Update(0xFFFFFFFFUL, &config, sizeof(Config));
+  return header;
+}
+
+bool configReadRecord(ConfigReader read, void *context, Config &out, uint32_t &sequence) {
+  ConfigHeader header;
+  if (read(context, (uint8_t *)&header, sizeof(header)) != sizeof(header) || header.magic != CONFIG_MAGIC) {
+    return false;
+  }
+
+  Config record = out;
+  size_t known = header.length < sizeof(Config) ? header.length : sizeof(Config);
+  if (read(context, (uint8_t *)&record, known) != known) {
+    return false;
+  }
+  uint32_t crc = crc32Update(0xFFFFFFFFUL, &record, known);
+
+  for (size_t remaining = header.length - known; remaining > 0;) {
+    uint8_t chunk[16];
+    size_t n = read(context, chunk, remaining < sizeof(chunk) ? remaining : sizeof(chunk));
+    if (n == 0) {
+      return false;
+    }
+    crc = crc32Update(crc, chunk, n);
+    remaining -= n;
+  }
+  if (~crc != header.crc) {
+    return false;
+  }
+
+  out = record;
+  sequence = header.sequence;
+  return true;
+}
+
+bool configLegacyValid(const Config &legacy) {
+  return isPrintableField(legacy.wifi_ssid, sizeof(legacy.wifi_ssid)) &&
+         isPrintableField(legacy.wifi_password, sizeof(legacy.wifi_password)) &&
+         isPrintableField(legacy.mqtt_server, sizeof(legacy.mqtt_server)) &&
+         isPrintableField(legacy.mqtt_user, sizeof(legacy.mqtt_user)) &&
+         isPrintableField(legacy.mqtt_password, sizeof(legacy.mqtt_password)) &&
+         legacy.mqtt_port > 0 && legacy.mqtt_port <= 65535 &&
+         (legacy.wifi_ssid[0] != '\0' || legacy.mqtt_server[0] != '\0');
+}
+
+bool isPrintableField(const char *field, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    if (field[i] == '\0') {
+      return true;
+    }
+    if (field[i] < 0x20 || field[i] > 0x7e) {
+      return false;
+    }
+  }
+  return false;
+}
+
+uint32_t crc32Update(uint32_t crc, const void *data, size_t length) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  while (length--) {
+    crc ^= *bytes++;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+    }
+  }
+  return crc;
+}
@@ -0,0 +1,75 @@
+// Persistent settings record. The sketch owns the storage (two LittleFS
+// slots); this module owns the layout, the checksum and the validation, so
+// record handling can be exercised on the host.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "schedule.h"
+
+#define CONFIG_MAGIC 0x43544B57UL  // "WKTC"
+#define CONFIG_VERSION 1
+
+// New fields go at the end: a record written by older firmware is shorter,
+// and the missing tail keeps CONFIG_DEFAULTS.
+struct Config {
+  char wifi_ssid[40];
+  char wifi_password[40];
+  char mqtt_server[40];
+  char mqtt_user[20];
+  char mqtt_password[20];
+  int32_t mqtt_port;
+  uint8_t sensor_type;   // LevelSensorType
+  uint8_t level_start;   // % at or below which a fill starts (continuous sensors)
+  uint8_t level_stop;    // % at or above which the tank is full (continuous sensors)
+  uint8_t reserved;
+  uint16_t cal_empty;    // Raw reading at 0% (ADC counts or distance in mm)
+  uint16_t cal_full;     // Raw reading at 100%
+  uint8_t power_mode;       // PowerMode
+  uint8_t power_reserved;
+  uint16_t power_latency_ms; // Longest command delay accepted in exchange for sleeping
+  char ntp_server[40];
+  char timezone[40];         // POSIX TZ string, e.g. "CET-1CEST,M3.5.0,M10.5.0/3"
+  ScheduleRule schedule[SCHEDULE_RULES];
+  char mqtt_prefix[24];      // Topics are <prefix>/<device id>/...; may hold '/' levels
+  char mqtt_group[24];       // Also obeys <prefix>/group/<group>/...; empty for none
+  uint8_t mqtt_tls;          // MqttTlsMode
+  uint8_t mqtt_tls_reserved;
+  char mqtt_fingerprint[60]; // Broker certificate SHA-1, hex, separators optional
+  uint16_t flow_pulses_per_litre; // Flow meter calibration; 0 when none is fitted
+  uint16_t flow_reserved;
+};
+
+// Each save goes to the slot not holding the current record, with a higher
+// sequence number, so an interrupted write leaves the previous record intact.
+struct ConfigHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t length;    // Bytes of Config that follow
+  uint32_t sequence;  // The valid record with the highest sequence wins
+  uint32_t crc;       // CRC32 of the Config bytes
+};
+
+extern const Config CONFIG_DEFAULTS;
+
+// Reads up to `length` bytes of a stored record, returns the number read.
+typedef size_t (*ConfigReader)(void *context, uint8_t *buffer, size_t length);
+
+// Header for writing `config` as record number `sequence`.
+ConfigHeader configMakeHeader(const Config &config, uint32_t sequence);
+
+// Reads a header and record into `out`, which must hold the defaults.
+// Returns false for a foreign, truncated or corrupt record and leaves `out`
+// alone. A record from newer firmware may be longer than Config; the extra
+// tail is checked but ignored, so going back to an older build keeps the
+// settings.
+bool configReadRecord(ConfigReader read, void *context, Config &out, uint32_t &sequence);
+
+// Sanity checks for a record laid out by firmware that predates the header.
+bool configLegacyValid(const Config &legacy);
+
+// True if `field` is a NUL-terminated string of printable ASCII.
+bool isPrintableField(const char *field, size_t size);
+
+// Bitwise CRC32 (IEEE). Start from 0xFFFFFFFF and invert the final value.
+uint32_t crc32Update(uint32_t crc, const void *data, size_t length);
@@ -0,0 +1,63 @@
+#include "flow_meter.h"
+
+void flowMeterBegin(FlowMeter &meter, uint16_t pulsesPerLitre, uint32_t primeMs, uint32_t noFlowMs,
+                    uint32_t retryMs, uint32_t count, uint32_t now) {
+  meter = FlowMeter();
+  meter.pulsesPerLitre = pulsesPerLitre;
+  meter.primeMs = primeMs;
+  meter.noFlowMs = noFlowMs;
+  meter.retryMs = retryMs;
+  meter.lastCount = count;
+  meter.lastTickAt = now;
+}
+
+FlowTick flowMeterTick(FlowMeter &meter, uint32_t count, uint32_t now, bool pumpOn) {
+  FlowTick tick = {};
+  uint32_t pulses = count - meter.lastCount;
+  uint32_t elapsed = now - meter.lastTickAt;
+  meter.lastCount = count;
+  meter.lastTickAt = now;
+  if (meter.pulsesPerLitre == 0) {
+    return tick;
+  }
+
+  meter.totalPulses += pulses;
+  if (elapsed > 0) {
+    uint32_t rate = (uint32_t)((uint64_t)pulses * 1000 * 60000 / ((uint64_t)meter.pulsesPerLitre * elapsed));
+    meter.rateMlPerMin = meter.rateMlPerMin - meter.rateMlPerMin / 4 + rate / 4;
+  }
+
+  if (pumpOn && !meter.running) {
+    meter.cyclePulses = 0;
+    meter.lastFlowAt = now + meter.primeMs;  // Priming counts as flowing
+  }
+  if (pumpOn) {
+    meter.cyclePulses += pulses;
+    if (pulses > 0 && (int32_t)(now - meter.lastFlowAt) > 0) {
+      meter.lastFlowAt = now;
+    }
+    if (!meter.fault && (int32_t)(now - meter.lastFlowAt) >= (int32_t)meter.noFlowMs) {
+      meter.fault = true;
+      meter.faultAt = now;
+      tick.faultRaised = true;
+    }
+  } else if (meter.running) {
+    tick.cycleEnded = true;
+    tick.cycleMl = (uint32_t)flowMeterMillilitres(meter, meter.cyclePulses);
+  }
+  meter.running = pumpOn;
+
+  if (meter.fault && !tick.faultRaised && now - meter.faultAt >= meter.retryMs) {
+    meter.fault = false;
+    tick.faultCleared = true;
+  }
+  return tick;
+}
+
+void flowMeterClearFault(FlowMeter &meter) {
+  meter.fault = false;
+}
+
+uint64_t flowMeterMillilitres(const FlowMeter &meter, uint64_t pulses) {
+  return meter.pulsesPerLitre ? pulses * 1000 / meter.pulsesPerLitre : 0;
+}
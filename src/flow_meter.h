@@ -0,0 +1,49 @@
+// Flow meter accounting. A hall-effect meter gives a fixed number of pulses
+// per litre; the sketch counts them in an interrupt and hands the running
+// count to flowMeterTick() once per scheduler tick, which works out the
+// rate, totals the volume of each pump run and watches for a pump that runs
+// without moving water (dry running, a clogged intake, a closed valve).
+//
+// A no-flow fault is raised once the pump has run for `primeMs` and then
+// seen no pulse for `noFlowMs`. It latches, so the pump stays off rather
+// than cycling into the same fault, until `retryMs` has passed or it is
+// cleared by hand.
+#pragma once
+
+#include <stdint.h>
+
+struct FlowMeter {
+  uint16_t pulsesPerLitre;  // 0 = no meter fitted; ticks then do nothing
+  uint32_t primeMs;         // Grace after a start before no-flow counts
+  uint32_t noFlowMs;        // Longest gap between pulses while running
+  uint32_t retryMs;         // A latched fault clears itself after this long
+  uint32_t lastCount;       // Pulse counter at the previous tick
+  uint32_t lastTickAt;
+  uint32_t rateMlPerMin;    // Smoothed flow rate
+  uint32_t cyclePulses;     // Pulses in the current (or last) pump run
+  uint64_t totalPulses;     // Since boot
+  bool running;             // Pump was ON at the previous tick
+  uint32_t lastFlowAt;      // Last tick with pulses; starts primeMs ahead on a start
+  bool fault;               // No-flow fault latched
+  uint32_t faultAt;
+};
+
+struct FlowTick {
+  bool cycleEnded;    // The pump stopped this tick; cycleMl holds the run's volume
+  uint32_t cycleMl;
+  bool faultRaised;
+  bool faultCleared;  // The retry time ran out
+};
+
+// Resets the meter. `count` is the pulse counter's current value.
+void flowMeterBegin(FlowMeter &meter, uint16_t pulsesPerLitre, uint32_t primeMs, uint32_t noFlowMs,
+                    uint32_t retryMs, uint32_t count, uint32_t now);
+
+// Takes the pulse counter's value at `now`. The counter may wrap.
+FlowTick flowMeterTick(FlowMeter &meter, uint32_t count, uint32_t now, bool pumpOn);
+
+// Clears a latched no-flow fault.
+void flowMeterClearFault(FlowMeter &meter);
+
+// Volume of `pulses` in millilitres.
+uint64_t flowMeterMillilitres(const FlowMeter &meter, uint64_t pulses);
@@ -0,0 +1,16 @@
+// Thin hardware interface for the control logic in src/. The sketch builds
+// hal_arduino.cpp on the device; the host tests link test/sim_hal.cpp, which
+// runs on a simulated clock and scripted pin levels.
+#pragma once
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#elif !defined(IRAM_ATTR)
+#define IRAM_ATTR
+#endif
+
+uint32_t halMillis();
+bool halDigitalRead(uint8_t pin);  // True for HIGH. Safe to call from the timer1 ISR
+void halDigitalWrite(uint8_t pin, bool high);
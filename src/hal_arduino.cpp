@@ -0,0 +1,67 @@
+#ifdef ARDUINO
+
+#include "hal.h"
+
+uint32_t halMillis() {
+  return millis();
+}
+
+#ifdef ESP8266
+
+// Straight to the GPIO registers: one load or store, where digitalRead() and
+// digitalWrite() look the pin up and check for PWM first. GPIO16 sits in the
+// RTC block with registers of its own.
+bool IRAM_ATTR halDigitalRead(uint8_t pin) {
+  return pin < 16 ? (GPI & (1UL << pin)) != 0 : (GP16I & 0x01) != 0;
+}
+
+void IRAM_ATTR halDigitalWrite(uint8_t pin, bool high) {
+  if (pin < 16) {
+    if (high) {
+      GPOS = 1UL << pin;
+    } else {
+      GPOC = 1UL << pin;
+    }
+  } else if (high) {
+    GP16O |= 0x01;
+  } else {
+    GP16O &= ~0x01;
+  }
+}
+
+#elif defined(ESP32)
+
+#include <soc/gpio_struct.h>
+
+// Same on the ESP32, whose GPIO32-39 live in a second set of registers.
+bool IRAM_ATTR halDigitalRead(uint8_t pin) {
+  return pin < 32 ? (GPIO.in & (1UL << pin)) != 0 : (GPIO.in1.val & (1UL << (pin - 32))) != 0;
+}
+
+void IRAM_ATTR halDigitalWrite(uint8_t pin, bool high) {
+  if (pin < 32) {
+    if (high) {
+      GPIO.out_w1ts = 1UL << pin;
+    } else {
+      GPIO.out_w1tc = 1UL << pin;
+    }
+  } else if (high) {
+    GPIO.out1_w1ts.val = 1UL << (pin - 32);
+  } else {
+    GPIO.out1_w1tc.val = 1UL << (pin - 32);
+  }
+}
+
+#else
+
+bool IRAM_ATTR halDigitalRead(uint8_t pin) {
+  return digitalRead(pin) == HIGH;
+}
+
+void halDigitalWrite(uint8_t pin, bool high) {
+  digitalWrite(pin, high ? HIGH : LOW);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,35 @@
+#include "mqtt_commands.h"
+
+#include <string.h>
+
+MqttResult mqttDispatch(const MqttRoute *routes, size_t count, const char *base, const char *topic,
+                  const uint8_t *payload, unsigned int length) {
+  size_t baseLength = strlen(base);
+  if (strncmp(topic, base, baseLength) != 0) {
+    return MQTT_NO_ROUTE;
+  }
+
+  const char *suffix = topic + baseLength;
+  uint32_t hash = topicHash(suffix);
+  for (size_t i = 0; i < count; i++) {
+    if (routes[i].hash == hash && strcmp(routes[i].suffix, suffix) == 0) {
+      return routes[i].handler(payload, length) ? MQTT_ACCEPTED : MQTT_REJECTED;
+    }
+  }
+  return MQTT_NO_ROUTE;
+}
+
+bool payloadIs(const uint8_t *payload, unsigned int length, const char *word) {
+  return length == strlen(word) && memcmp(payload, word, length) == 0;
+}
+
+bool mqttTopicNameValid(const char *text, bool levels) {
+  char previous = '/';
+  for (const char *c = text; *c; c++) {
+    if (*c < 0x21 || *c > 0x7E || *c == '+' || *c == '#' || (*c == '/' && (!levels || previous == '/'))) {
+      return false;
+    }
+    previous = *c;
+  }
+  return previous != '/';
+}
@@ -0,0 +1,43 @@
+// MQTT command routing
+// Each route maps a topic suffix under the base topic to a handler. The
+// suffix hash is computed at compile time, so dispatching an incoming message
+// costs one hash of the topic and a strcmp() on the matching entry. Handlers
+// parse the payload in place; it is not NUL-terminated, and return whether
+// they accepted the command, which the sketch reports back as an ack.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+constexpr uint32_t topicHash(const char *s) {
+  uint32_t h = 2166136261u;  // FNV-1a
+  while (*s) {
+    h = (h ^ (uint8_t)*s++) * 16777619u;
+  }
+  return h;
+}
+
+typedef bool (*MqttHandler)(const uint8_t *payload, unsigned int length);
+
+enum MqttResult { MQTT_NO_ROUTE, MQTT_ACCEPTED, MQTT_REJECTED };
+
+struct MqttRoute {
+  const char *suffix;
+  uint32_t hash;
+  MqttHandler handler;
+};
+
+#define MQTT_ROUTE(suffix, handler) { suffix, topicHash(suffix), handler }
+
+// Calls the handler whose suffix completes `topic` after `base`. Returns
+// MQTT_NO_ROUTE (false) for a topic outside `base` or without a route.
+MqttResult mqttDispatch(const MqttRoute *routes, size_t count, const char *base, const char *topic,
+                  const uint8_t *payload, unsigned int length);
+
+// True if the payload is exactly `word`.
+bool payloadIs(const uint8_t *payload, unsigned int length, const char *word);
+
+// True if `text` can go into a topic as configured: non-empty, printable,
+// no wildcards, and no empty levels. `levels` false also rejects '/', for a
+// name that must stay a single topic level.
+bool mqttTopicNameValid(const char *text, bool levels);
@@ -0,0 +1,154 @@
+#include "ota_manifest.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool isHexDigit(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static bool isHexString(const char *s, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    if (!isHexDigit(s[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Copies a value of `length` bytes into a field of `size`, refusing to truncate.
+static bool copyField(char *field, size_t size, const char *value, size_t length) {
+  if (length >= size) {
+    return false;
+  }
+  memcpy(field, value, length);
+  field[length] = '\0';
+  return true;
+}
+
+// Checks a hex digest value of exactly `digits` digits and copies it.
+static bool copyDigest(char *field, size_t digits, const char *value, size_t length) {
+  return length == digits && isHexString(value, length) && copyField(field, digits + 1, value, length);
+}
+
+// Reads one dotted-decimal part. False on anything but digits, or a part
+// too large for 32 bits.
+static bool versionPart(const char *&s, uint32_t &part) {
+  if (*s < '0' || *s > '9') {
+    return false;
+  }
+  uint64_t value = 0;
+  for (; *s >= '0' && *s <= '9'; s++) {
+    value = value * 10 + (*s - '0');
+    if (value > 0xFFFFFFFFu) {
+      return false;
+    }
+  }
+  part = (uint32_t)value;
+  return *s == '\0' || *s == '.';
+}
+
+static bool versionValid(const char *s) {
+  uint32_t part;
+  while (versionPart(s, part)) {
+    if (*s == '\0') {
+      return true;
+    }
+    s++;  // Past the '.'
+  }
+  return false;
+}
+
+bool otaParseManifest(const char *text, OtaManifest &out) {
+  memset(&out, 0, sizeof(out));
+
+  for (const char *line = text; *line;) {
+    const char *end = strchr(line, '\n');
+    size_t length = end ? (size_t)(end - line) : strlen(line);
+    size_t valueLength = length > 0 && line[length - 1] == '\r' ? length - 1 : length;
+    const char *equals = (const char *)memchr(line, '=', valueLength);
+    const char *next = end ? end + 1 : line + length;
+
+    if (valueLength == 0) {
+      line = next;
+      continue;
+    }
+    if (!equals) {
+      return false;
+    }
+
+    size_t keyLength = equals - line;
+    const char *value = equals + 1;
+    valueLength -= keyLength + 1;
+    bool ok = true;
+
+    if (keyLength == 3 && memcmp(line, "sig", 3) == 0) {
+      out.signature = value;
+      out.signatureLength = valueLength;
+      out.signedLength = line - text;
+      for (; *next; next++) {
+        if (*next != '\r' && *next != '\n') {
+          return false;  // Unsigned trailing content
+        }
+      }
+      break;
+    } else if (keyLength == 7 && memcmp(line, "version", 7) == 0) {
+      ok = copyField(out.version, sizeof(out.version), value, valueLength);
+    } else if (keyLength == 3 && memcmp(line, "url", 3) == 0) {
+      ok = copyField(out.url, sizeof(out.url), value, valueLength);
+    } else if (keyLength == 3 && memcmp(line, "md5", 3) == 0) {
+      ok = copyDigest(out.md5, OTA_MD5_HEX, value, valueLength);
+    } else if (keyLength == 6 && memcmp(line, "sha256", 6) == 0) {
+      ok = copyDigest(out.sha256, OTA_SHA256_HEX, value, valueLength);
+    } else if (keyLength == 12 && memcmp(line, "rollback_url", 12) == 0) {
+      ok = copyField(out.rollbackUrl, sizeof(out.rollbackUrl), value, valueLength);
+    } else if (keyLength == 12 && memcmp(line, "rollback_md5", 12) == 0) {
+      ok = copyDigest(out.rollbackMd5, OTA_MD5_HEX, value, valueLength);
+    } else if (keyLength == 15 && memcmp(line, "rollback_sha256", 15) == 0) {
+      ok = copyDigest(out.rollbackSha256, OTA_SHA256_HEX, value, valueLength);
+    }
+    if (!ok) {
+      return false;
+    }
+    line = next;
+  }
+
+  bool rollback = out.rollbackUrl[0] != '\0';
+  return out.signature && out.signatureLength > 0 && out.version[0] && versionValid(out.version) &&
+         out.url[0] && out.md5[0] && out.sha256[0] &&
+         (out.rollbackMd5[0] != '\0') == rollback && (out.rollbackSha256[0] != '\0') == rollback;
+}
+
+bool otaVersionNewer(const char *candidate, const char *current) {
+  if (!versionValid(candidate) || !versionValid(current)) {
+    return false;
+  }
+  const char *a = candidate;
+  const char *b = current;
+  while (*a || *b) {
+    uint32_t x = 0, y = 0;
+    if (*a) {
+      versionPart(a, x);
+      a += *a == '.';
+    }
+    if (*b) {
+      versionPart(b, y);
+      b += *b == '.';
+    }
+    if (x != y) {
+      return x > y;
+    }
+  }
+  return false;
+}
+
+size_t hexDecode(const char *hex, size_t length, uint8_t *out, size_t size) {
+  if (length % 2 != 0 || length / 2 > size || !isHexString(hex, length)) {
+    return 0;
+  }
+  for (size_t i = 0; i < length / 2; i++) {
+    char pair[3] = { hex[2 * i], hex[2 * i + 1], '\0' };
+    out[i] = (uint8_t)strtoul(pair, nullptr, 16);
+  }
+  return length / 2;
+}
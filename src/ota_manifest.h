@@ -0,0 +1,54 @@
+// Firmware update manifest. Plain text, one key=value per line:
+//
+//   version=1.4.0
+//   url=http://updates.example/watertank-1.4.0.bin.gz
+//   md5=<32 hex digits of the image as served>
+//   sha256=<64 hex digits of the image as served>
+//   rollback_url=http://updates.example/watertank-1.3.2.bin.gz   (optional)
+//   rollback_md5=<32 hex digits>                                  (optional)
+//   rollback_sha256=<64 hex digits>                               (optional)
+//   sig=<hex signature of every byte before this line>
+//
+// The version is dotted decimal and an update is only taken if it is newer
+// than the running firmware, so an old signed manifest cannot be replayed
+// to downgrade a unit. The MD5 is what the flash updater checks; the
+// SHA-256 is what the signature actually vouches for.
+//
+// Unknown keys are ignored. The sig line must come last. tools/ota_sign.py
+// writes manifests in this form; the signature itself is checked by the
+// sketch with the key built into the firmware.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OTA_VERSION_MAX 16
+#define OTA_URL_MAX 128
+#define OTA_MD5_HEX 32
+#define OTA_SHA256_HEX 64
+
+struct OtaManifest {
+  char version[OTA_VERSION_MAX];
+  char url[OTA_URL_MAX];
+  char md5[OTA_MD5_HEX + 1];
+  char sha256[OTA_SHA256_HEX + 1];
+  char rollbackUrl[OTA_URL_MAX];  // Empty if the manifest names no rollback image
+  char rollbackMd5[OTA_MD5_HEX + 1];
+  char rollbackSha256[OTA_SHA256_HEX + 1];
+  const char *signature;          // Hex, points into the parsed text
+  size_t signatureLength;
+  size_t signedLength;            // Bytes of the text covered by the signature
+};
+
+// Parses `text` (NUL-terminated). False if a required field is missing,
+// malformed or too long, or if anything follows the sig line.
+bool otaParseManifest(const char *text, OtaManifest &out);
+
+// True if `candidate` is a later version than `current`. Both must be
+// dotted decimal ("1.4.0"); missing parts count as 0, so "1.4" equals
+// "1.4.0". False if either is malformed.
+bool otaVersionNewer(const char *candidate, const char *current);
+
+// Decodes `length` hex digits into `out`. Returns the bytes written, or 0 for
+// an odd length, a non-hex digit or a result larger than `size`.
+size_t hexDecode(const char *hex, size_t length, uint8_t *out, size_t size);
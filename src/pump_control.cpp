@@ -0,0 +1,95 @@
+#include "pump_control.h"
+#include "hal.h"
+
+const char *const PUMP_STATE_NAMES[] = { "IDLE", "FILLING", "FULL", "FAULT", "OVERRIDE", "INTERLOCK" };
+
+// The one place the relay's polarity is applied.
+static void driveRelay(const PumpControl &pump, bool on) {
+  halDigitalWrite(pump.relayPin, on == pump.relayActiveHigh);
+}
+
+void pumpControlBegin(PumpControl &pump, uint8_t relayPin, bool relayActiveHigh, uint32_t minRunMs,
+                      uint32_t minRestMs) {
+  pump.relayPin = relayPin;
+  pump.relayActiveHigh = relayActiveHigh;
+  pump.minRunMs = minRunMs;
+  pump.minRestMs = minRestMs;
+  pump.state = PUMP_IDLE;
+  pump.on = false;
+  pump.hasSwitched = false;
+  pump.switchedAt = 0;
+  pump.toppedUp = false;
+  driveRelay(pump, false);
+}
+
+// State the tank's own level asks for.
+static PumpState levelState(const PumpControl &pump, const PumpInputs &in) {
+  if (in.fault) {
+    return PUMP_FAULT;  // No trustworthy level reading
+  }
+  if (in.noFlow) {
+    return PUMP_FAULT;  // Ran dry or the intake is blocked
+  }
+  if (in.high && !in.low) {
+    return PUMP_FAULT;  // Water above the high float but not the low one: a float is stuck
+  }
+  if (in.high) {
+    return PUMP_FULL;
+  }
+  if (!in.low) {
+    return PUMP_FILLING;  // Both floats dry, tank empty
+  }
+  // Between the floats
+  if (in.peak) {
+    return PUMP_IDLE;  // Off empty is enough until the tariff drops
+  }
+  if (in.topUp && !pump.toppedUp) {
+    return PUMP_FILLING;
+  }
+  return pump.on || pump.state == PUMP_INTERLOCK ? PUMP_FILLING : PUMP_IDLE;
+}
+
+PumpState pumpNextState(const PumpControl &pump, const PumpInputs &in) {
+  if (in.overrideMode) {
+    return PUMP_OVERRIDE;
+  }
+  PumpState next = levelState(pump, in);
+  if (next == PUMP_FILLING && in.sourceLow) {
+    return PUMP_INTERLOCK;  // The pump would run dry
+  }
+  return next;
+}
+
+PumpStep pumpControlUpdate(PumpControl &pump, const PumpInputs &in) {
+  PumpStep step = { false, false, false, pump.state };
+  if (!in.topUp) {
+    pump.toppedUp = false;  // The next window tops up again
+  }
+  PumpState next = pumpNextState(pump, in);
+  bool wantOn = next == PUMP_OVERRIDE ? in.overrideState : next == PUMP_FILLING;
+
+  if (wantOn != pump.on && pump.hasSwitched && next != PUMP_FAULT && next != PUMP_OVERRIDE &&
+      next != PUMP_INTERLOCK) {
+    uint32_t minTime = pump.on ? pump.minRunMs : pump.minRestMs;
+    if (halMillis() - pump.switchedAt < minTime) {
+      step.deferred = true;
+      return step;
+    }
+  }
+
+  if (next != pump.state) {
+    pump.state = next;
+    step.stateChanged = true;
+  }
+  if (in.topUp && next == PUMP_FULL) {
+    pump.toppedUp = true;
+  }
+  if (wantOn != pump.on) {
+    driveRelay(pump, wantOn);
+    pump.on = wantOn;
+    pump.hasSwitched = true;
+    pump.switchedAt = halMillis();
+    step.relayChanged = true;
+  }
+  return step;
+}
@@ -0,0 +1,70 @@
+// Pump state machine
+//   IDLE     level between the floats, pump OFF
+//   FILLING  pump ON until the high float is wet (or, at peak times, until
+//            the low float is wet again)
+//   FULL     high float wet, pump OFF
+//   FAULT    high float wet while the low float is dry, no trustworthy
+//            level reading, or the flow meter saw no water moving while
+//            the pump ran; pump OFF
+//   OVERRIDE relay follows the MQTT override command
+//   INTERLOCK a fill is due but the tank this pump draws from is below its
+//            low float (or has no trustworthy reading); pump OFF until it
+//            recovers, then the fill resumes
+//
+// Between the floats the pump keeps doing what it was doing, except that a
+// top-up window starts one fill to the high float, and a peak window stops
+// a fill there. Both floats dry always starts a fill.
+//
+// The relay is driven only from pumpControlUpdate(), through the HAL, and
+// only when its level changes. Side effects beyond the relay (logging,
+// statistics, events) are left to the caller, which gets a PumpStep back.
+#pragma once
+
+#include <stdint.h>
+
+enum PumpState { PUMP_IDLE, PUMP_FILLING, PUMP_FULL, PUMP_FAULT, PUMP_OVERRIDE, PUMP_INTERLOCK };
+extern const char *const PUMP_STATE_NAMES[];
+
+struct PumpInputs {
+  bool low;            // Low float WET
+  bool high;           // High float WET
+  bool fault;          // Level sensor has no trustworthy reading
+  bool overrideMode;
+  bool overrideState;  // Relay level while overrideMode is set
+  bool topUp;          // A top-up window is open, see src/schedule.h
+  bool peak;           // A peak window is open
+  bool sourceLow;      // The tank this pump draws from cannot supply it
+  bool noFlow;         // Latched no-flow fault, see src/flow_meter.h
+};
+
+struct PumpControl {
+  uint8_t relayPin;
+  bool relayActiveHigh; // Relay input level that runs the pump
+  uint32_t minRunMs;    // Pump stays ON at least this long once started
+  uint32_t minRestMs;   // Pump stays OFF at least this long once stopped
+  PumpState state;
+  bool on;
+  bool hasSwitched;     // False until the relay first changes after boot
+  uint32_t switchedAt;  // halMillis() of the last relay change
+  bool toppedUp;        // Reached FULL since the current top-up window opened
+};
+
+struct PumpStep {
+  bool deferred;       // Held back by the minimum run/rest time, call again later
+  bool stateChanged;
+  bool relayChanged;
+  PumpState previous;  // State before the update
+};
+
+// Drives the relay OFF and resets the state machine. `relayActiveHigh`
+// comes from the board profile, see src/board_profiles.h.
+void pumpControlBegin(PumpControl &pump, uint8_t relayPin, bool relayActiveHigh, uint32_t minRunMs,
+                      uint32_t minRestMs);
+
+// State the inputs ask for right now, ignoring the minimum run/rest times.
+PumpState pumpNextState(const PumpControl &pump, const PumpInputs &in);
+
+// Moves to the state the inputs ask for and switches the relay to match.
+// Relay changes requested by the floats are held back until the minimum
+// run/rest time has passed; FAULT, OVERRIDE and INTERLOCK switch immediately.
+PumpStep pumpControlUpdate(PumpControl &pump, const PumpInputs &in);
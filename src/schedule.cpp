@@ -0,0 +1,160 @@
+#include "schedule.h"
+
+#include <stdio.h>
+#include <string.h>
+
+const char *const SCHEDULE_ACTION_NAMES[] = { "none", "topup", "peak" };
+
+static const char *const DAY_NAMES[] = { "sun", "mon", "tue", "wed", "thu", "fri", "sat" };
+
+#define ALL_DAYS 0x7F
+#define MINUTES_PER_DAY 1440
+
+static bool ruleCovers(const ScheduleRule &rule, uint8_t weekday, uint16_t minute) {
+  uint8_t yesterday = (weekday + 6) % 7;
+  if (rule.start == rule.end) {
+    return rule.days & (1 << weekday);
+  }
+  if (rule.start < rule.end) {
+    return (rule.days & (1 << weekday)) && minute >= rule.start && minute < rule.end;
+  }
+  // Runs past midnight: the evening part belongs to today's bit, the
+  // morning part to yesterday's
+  return ((rule.days & (1 << weekday)) && minute >= rule.start) ||
+         ((rule.days & (1 << yesterday)) && minute < rule.end);
+}
+
+ScheduleAction scheduleActionAt(const ScheduleRule *rules, size_t count, uint8_t weekday, uint16_t minute) {
+  ScheduleAction action = SCHEDULE_NONE;
+  for (size_t i = 0; i < count; i++) {
+    if (rules[i].days == 0 || rules[i].action == SCHEDULE_NONE || !ruleCovers(rules[i], weekday, minute)) {
+      continue;
+    }
+    if (rules[i].action == SCHEDULE_PEAK) {
+      return SCHEDULE_PEAK;
+    }
+    action = (ScheduleAction)rules[i].action;
+  }
+  return action;
+}
+
+static int parseDay(const char *s) {
+  for (int i = 0; i < 7; i++) {
+    if (strncmp(s, DAY_NAMES[i], 3) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// "daily", or a comma list of days and day ranges. Ranges may wrap ("fri-mon").
+static bool parseDays(const char *s, size_t length, uint8_t &days) {
+  if (length == 5 && memcmp(s, "daily", 5) == 0) {
+    days = ALL_DAYS;
+    return true;
+  }
+  days = 0;
+  for (size_t i = 0; i < length;) {
+    if (length - i < 3) {
+      return false;
+    }
+    int first = parseDay(s + i);
+    int last = first;
+    i += 3;
+    if (i < length && s[i] == '-') {
+      if (length - i < 4) {
+        return false;
+      }
+      last = parseDay(s + i + 1);
+      i += 4;
+    }
+    if (first < 0 || last < 0) {
+      return false;
+    }
+    for (int d = first;; d = (d + 1) % 7) {
+      days |= 1 << d;
+      if (d == last) {
+        break;
+      }
+    }
+    if (i < length) {
+      if (s[i] != ',' || i + 1 == length) {
+        return false;
+      }
+      i++;
+    }
+  }
+  return days != 0;
+}
+
+static bool parseClock(const char *s, uint16_t &minute) {
+  if (s[0] < '0' || s[0] > '9' || s[1] < '0' || s[1] > '9' || s[2] != ':' ||
+      s[3] < '0' || s[3] > '9' || s[4] < '0' || s[4] > '9') {
+    return false;
+  }
+  int hours = (s[0] - '0') * 10 + (s[1] - '0');
+  int minutes = (s[3] - '0') * 10 + (s[4] - '0');
+  if (hours > 23 || minutes > 59) {
+    return false;
+  }
+  minute = hours * 60 + minutes;
+  return true;
+}
+
+bool scheduleParseRule(const char *text, size_t length, ScheduleRule &rule) {
+  while (length > 0 && (text[length - 1] == ' ' || text[length - 1] == '\r' || text[length - 1] == '\n')) {
+    length--;
+  }
+  if (length == 3 && memcmp(text, "off", 3) == 0) {
+    rule = ScheduleRule();
+    return true;
+  }
+
+  // Three space-separated fields: days, window, action
+  const char *space1 = (const char *)memchr(text, ' ', length);
+  if (!space1) {
+    return false;
+  }
+  const char *window = space1 + 1;
+  const char *space2 = (const char *)memchr(window, ' ', text + length - window);
+  if (!space2 || space2 - window != 11 || window[5] != '-') {
+    return false;
+  }
+  const char *action = space2 + 1;
+  size_t actionLength = text + length - action;
+
+  ScheduleRule parsed;
+  if (!parseDays(text, space1 - text, parsed.days) || !parseClock(window, parsed.start) ||
+      !parseClock(window + 6, parsed.end)) {
+    return false;
+  }
+  if (actionLength == 5 && memcmp(action, "topup", 5) == 0) {
+    parsed.action = SCHEDULE_TOP_UP;
+  } else if (actionLength == 4 && memcmp(action, "peak", 4) == 0) {
+    parsed.action = SCHEDULE_PEAK;
+  } else {
+    return false;
+  }
+  rule = parsed;
+  return true;
+}
+
+void scheduleFormatRule(const ScheduleRule &rule, char *out, size_t size) {
+  if (rule.days == 0 || rule.action == SCHEDULE_NONE || rule.action > SCHEDULE_PEAK ||
+      rule.start >= MINUTES_PER_DAY || rule.end >= MINUTES_PER_DAY) {
+    snprintf(out, size, "off");
+    return;
+  }
+
+  char days[7 * 4] = "daily";
+  if ((rule.days & ALL_DAYS) != ALL_DAYS) {
+    size_t n = 0;
+    for (int d = 0; d < 7; d++) {
+      if (rule.days & (1 << d)) {
+        n += snprintf(days + n, sizeof(days) - n, "%s%s", n ? "," : "", DAY_NAMES[d]);
+      }
+    }
+  }
+  snprintf(out, size, "%s %02u:%02u-%02u:%02u %s", days, rule.start / 60, rule.start % 60,
+           rule.end / 60, rule.end % 60, SCHEDULE_ACTION_NAMES[rule.action]);
+}
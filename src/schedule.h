@@ -0,0 +1,42 @@
+// Pumping schedule. A small table of weekly windows, each with an action,
+// evaluated against local wall-clock time:
+//   TOP_UP  when the window opens the tank is filled to the high float,
+//           for off-peak tariffs or hours with good mains pressure
+//   PEAK    a fill only runs until the low float is wet again, so the
+//           tank is kept off empty but the rest waits for cheaper hours
+// Outside any window, and whenever the clock is not set, the floats alone
+// decide. Where windows overlap PEAK wins.
+//
+// Rules are written as text, over MQTT and in the setup page:
+//   <days> <HH:MM>-<HH:MM> <topup|peak>     e.g. "mon-fri 23:00-06:30 topup"
+//   off
+// <days> is "daily", a day ("sat"), a range ("mon-fri") or a comma list of
+// those ("mon,wed,fri-sun"). A window whose end is before its start runs
+// past midnight into the next day.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SCHEDULE_RULES 6
+#define SCHEDULE_RULE_TEXT_MAX 48  // Longest formatted rule, with the NUL
+
+enum ScheduleAction : uint8_t { SCHEDULE_NONE, SCHEDULE_TOP_UP, SCHEDULE_PEAK };
+extern const char *const SCHEDULE_ACTION_NAMES[];
+
+struct ScheduleRule {
+  uint8_t days;    // bit0 Sunday .. bit6 Saturday, for the day the window opens; 0 = unused
+  uint8_t action;  // ScheduleAction
+  uint16_t start;  // Minute of the day the window opens, 0-1439
+  uint16_t end;    // Minute of the day it closes; equal to start means all day
+};
+
+// Action in force at `minute` (0-1439) of `weekday` (0 = Sunday).
+ScheduleAction scheduleActionAt(const ScheduleRule *rules, size_t count, uint8_t weekday, uint16_t minute);
+
+// Parses one rule in the form above. False, with `rule` untouched, if the
+// text is not a valid rule. "off" gives an unused rule.
+bool scheduleParseRule(const char *text, size_t length, ScheduleRule &rule);
+
+// Writes `rule` in the form scheduleParseRule() accepts ("off" if unused).
+void scheduleFormatRule(const ScheduleRule &rule, char *out, size_t size);
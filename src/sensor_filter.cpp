@@ -0,0 +1,32 @@
+#include "sensor_filter.h"
+
+static const uint16_t WINDOW_MASK = (uint16_t)((1UL << SAMPLE_WINDOW) - 1);
+
+void sensorFilterSeed(SensorFilter &f, bool wet) {
+  f.history = wet ? WINDOW_MASK : 0;
+  f.highCount = wet ? SAMPLE_WINDOW : 0;
+  f.state = wet;
+}
+
+void IRAM_ATTR sensorFilterSample(SensorFilter &f, bool high) {
+  uint8_t sample = high ? 1 : 0;
+  uint8_t oldest = (f.history >> (SAMPLE_WINDOW - 1)) & 1;
+
+  f.history = ((f.history << 1) | sample) & WINDOW_MASK;
+  f.highCount = f.highCount + sample - oldest;
+
+  if (!f.state && f.highCount >= SAMPLE_WET_COUNT) {
+    f.state = true;
+  } else if (f.state && f.highCount <= SAMPLE_DRY_COUNT) {
+    f.state = false;
+  }
+}
+
+bool sensorFilterRead(const SensorFilter *filters, size_t count, uint8_t pin) {
+  for (size_t i = 0; i < count; i++) {
+    if (filters[i].pin == pin) {
+      return filters[i].state;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,33 @@
+// Float switch debounce. `history` is a ring buffer holding one bit per
+// sample, newest in bit 0; `highCount` tracks how many of those bits are set
+// so the vote never has to rescan the window. The WET/DRY thresholds give the
+// vote some hysteresis so a pin hovering at 50% does not flap.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hal.h"
+
+#define SAMPLE_WINDOW 16         // Samples kept per pin (80 ms at 200 Hz)
+#define SAMPLE_WET_COUNT 11      // Switch to WET once this many samples are HIGH
+#define SAMPLE_DRY_COUNT 5       // Switch to DRY once this few samples are HIGH
+
+struct SensorFilter {
+  uint8_t pin;
+  volatile uint16_t history;
+  volatile uint8_t highCount;
+  volatile bool state;  // Filtered level, true = WET
+};
+
+static_assert(SAMPLE_WINDOW <= 16, "SensorFilter::history holds at most 16 samples");
+
+// Fills the window with `wet` so the first filtered reading is real rather
+// than a window full of DRY samples.
+void sensorFilterSeed(SensorFilter &f, bool wet);
+
+// Adds one sample (true = HIGH, submerged) and updates the vote. Runs in the
+// timer1 ISR.
+void sensorFilterSample(SensorFilter &f, bool high);
+
+// Latest debounced level of `pin`, false for a pin without a filter.
+bool sensorFilterRead(const SensorFilter *filters, size_t count, uint8_t pin);
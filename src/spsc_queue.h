@@ -0,0 +1,52 @@
+// Lock-free single-producer, single-consumer queue. On the ESP32 the
+// control and networking tasks run on different cores and hand each other
+// commands and event records through these; on the ESP8266 both ends run in
+// loop() and the queue is just a ring buffer.
+//
+// Exactly one task may push and exactly one other may pop. Each index is
+// written only by its own end, and an index is published with release
+// ordering after the slot it covers is written, so neither end needs a
+// lock or a read-modify-write instruction.
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+template <typename T, size_t N>
+struct SpscQueue {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+  T items[N];
+  std::atomic<uint32_t> head{0};  // Next slot to write, only the producer stores it
+  std::atomic<uint32_t> tail{0};  // Next slot to read, only the consumer stores it
+};
+
+// Producer side. False, and nothing queued, when the queue is full.
+template <typename T, size_t N>
+bool spscPush(SpscQueue<T, N> &queue, const T &item) {
+  uint32_t head = queue.head.load(std::memory_order_relaxed);
+  if (head - queue.tail.load(std::memory_order_acquire) >= N) {
+    return false;
+  }
+  queue.items[head % N] = item;
+  queue.head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+// Consumer side. False when the queue is empty.
+template <typename T, size_t N>
+bool spscPop(SpscQueue<T, N> &queue, T &item) {
+  uint32_t tail = queue.tail.load(std::memory_order_relaxed);
+  if (tail == queue.head.load(std::memory_order_acquire)) {
+    return false;
+  }
+  item = queue.items[tail % N];
+  queue.tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+// Items waiting. Either end may call it; the answer may already be stale.
+template <typename T, size_t N>
+uint32_t spscCount(const SpscQueue<T, N> &queue) {
+  return queue.head.load(std::memory_order_acquire) - queue.tail.load(std::memory_order_acquire);
+}
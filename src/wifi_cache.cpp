@@ -0,0 +1,42 @@
+#include "wifi_cache.h"
+
+#include <string.h>
+#include "config_store.h"
+
+static uint32_t cacheCrc(const WifiCache &cache) {
+  return ~crc32Update(0xFFFFFFFFUL, &cache, offsetof(WifiCache, crc));
+}
+
+uint32_t wifiCacheKey(const char *ssid, const char *password) {
+  uint32_t crc = crc32Update(0xFFFFFFFFUL, ssid, strlen(ssid) + 1);  // The NUL keeps "ab"+"c" apart from "a"+"bc"
+  return ~crc32Update(crc, password, strlen(password));
+}
+
+void wifiCacheSeal(WifiCache &cache, uint32_t key) {
+  cache.magic = WIFI_CACHE_MAGIC;
+  cache.key = key;
+  cache.crc = cacheCrc(cache);
+}
+
+bool wifiCacheUsable(const WifiCache &cache, uint32_t key) {
+  static const uint8_t NO_BSSID[6] = {};
+  return cache.magic == WIFI_CACHE_MAGIC && cache.key == key && cache.crc == cacheCrc(cache) &&
+         cache.channel >= 1 && cache.channel <= 14 && memcmp(cache.bssid, NO_BSSID, sizeof(NO_BSSID)) != 0 &&
+         cache.ip != 0 && cache.subnet != 0 && cache.joins < WIFI_CACHE_MAX_JOINS;
+}
+
+void wifiCacheCountJoin(WifiCache &cache, uint32_t key) {
+  if (cache.joins < UINT8_MAX) {
+    cache.joins++;
+  }
+  wifiCacheSeal(cache, key);
+}
+
+void wifiCacheSealJoin(WifiCache &join, const WifiCache &current, bool fastJoin, uint32_t key) {
+  join.joins = fastJoin ? current.joins : 0;
+  wifiCacheSeal(join, key);
+}
+
+bool wifiCacheSame(const WifiCache &a, const WifiCache &b) {
+  return memcmp(&a, &b, offsetof(WifiCache, crc)) == 0;
+}
@@ -0,0 +1,54 @@
+// Fast-join cache. After a normal join (scan, then DHCP) the sketch stores
+// the access point's BSSID and channel and the address the DHCP server
+// handed out. The next join goes straight to that AP on that channel with
+// the address set statically, which skips both the scan and the DHCP
+// exchange. The record is keyed to the credentials, so changing network
+// throws it away.
+//
+// The DHCP server only promised the address for its lease time, which the
+// sketch cannot see. So a cached address is used for at most
+// WIFI_CACHE_MAX_JOINS fast joins, and the sketch renews it over DHCP once
+// a fast join has been up for a while (WIFI_CACHE_RENEW_MS in the sketch).
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WIFI_CACHE_MAGIC 0x43465457UL  // "WTFC"
+#define WIFI_CACHE_MAX_JOINS 4          // Fast joins on one lease before DHCP is asked again
+
+struct WifiCache {
+  uint32_t magic;
+  uint32_t key;       // wifiCacheKey() of the credentials it was made with
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t joins;      // Fast joins made with this lease so far
+  uint32_t ip;        // Lease from the last DHCP exchange, reused as a static address
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+  uint32_t crc;       // CRC32 of everything above
+};
+
+// Identifies a network by its SSID and password.
+uint32_t wifiCacheKey(const char *ssid, const char *password);
+
+// Sets magic, key and crc; the other fields, `joins` included, must already
+// be filled in.
+void wifiCacheSeal(WifiCache &cache, uint32_t key);
+
+// True if `cache` is intact, was made for `key`, holds a usable join and its
+// lease has not been reused WIFI_CACHE_MAX_JOINS times yet.
+bool wifiCacheUsable(const WifiCache &cache, uint32_t key);
+
+// Counts one more fast join on `cache`'s lease and reseals it. The caller
+// writes it back before joining, so the count survives a reboot.
+void wifiCacheCountJoin(WifiCache &cache, uint32_t key);
+
+// Seals `join`, freshly filled in from the station, for storing. A fast
+// join keeps the use count of `current`, the record it was made from; a
+// DHCP join starts a new lease at 0.
+void wifiCacheSealJoin(WifiCache &join, const WifiCache &current, bool fastJoin, uint32_t key);
+
+// True if the two records describe the same join, to skip rewriting flash.
+bool wifiCacheSame(const WifiCache &a, const WifiCache &b);
@@ -0,0 +1,173 @@
+// Replays days of tank behaviour through the float filters and the pump
+// state machine at the sketch's real sample and task rates, then times the
+// decision itself in a tight loop. Fails if the tank overflows or runs dry,
+// or if anything on the control path allocates.
+//
+//   bench_pump_control [days]   (default 7)
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim_hal.h"
+#include "sim_unit.h"
+
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  void *p = malloc(size ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  free(p);
+}
+
+// 1000 L tank with the floats at 300 L and 900 L, a 48 L/min pump, and a
+// household drawing a trickle all day with morning and evening peaks.
+#define TANK_CAPACITY_L 1000.0
+#define TANK_LOW_FLOAT_L 300.0
+#define TANK_HIGH_FLOAT_L 900.0
+#define TANK_RIPPLE_L 4.0     // Surface ripple at the floats, peak to peak
+#define PUMP_FLOW_LPS 0.8
+
+// The floats at `low`/`high` plus up to two other inputs set; the rest,
+// including any input added later, stay off.
+static PumpInputs benchInputs(bool low, bool high, bool PumpInputs::*flag = nullptr,
+                              bool PumpInputs::*other = nullptr) {
+  PumpInputs in = {};
+  in.low = low;
+  in.high = high;
+  if (flag) {
+    in.*flag = true;
+  }
+  if (other) {
+    in.*other = true;
+  }
+  return in;
+}
+
+static double demandLps(uint32_t ms) {
+  uint32_t hour = (ms / 3600000UL) % 24;
+  if (hour >= 6 && hour < 8) {
+    return 0.5;
+  }
+  if (hour >= 18 && hour < 21) {
+    return 0.4;
+  }
+  return 0.05;
+}
+
+// Triangle wave plus a little noise, so the level chatters across a float for
+// a while each time it passes.
+static double ripple(uint32_t ms, uint32_t &seed) {
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  double phase = (ms % 700) / 700.0;
+  double wave = phase < 0.5 ? phase * 2 : 2 - phase * 2;
+  return (wave - 0.5) * TANK_RIPPLE_L + ((seed & 0xFF) / 255.0 - 0.5);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+  uint32_t days = argc > 1 ? strtoul(argv[1], nullptr, 10) : 7;
+  bool ok = true;
+
+  // Replay
+  simReset();
+  simSetPin(SIM_LOW_PIN, true);
+  SimUnit unit;
+  simUnitBegin(unit);
+  double level = 500.0;
+  double minLevel = level;
+  double maxLevel = level;
+  uint32_t seed = 2463534242u;
+  const uint32_t duration = days * 86400000UL;
+  const double stepSeconds = SIM_SAMPLE_MS / 1000.0;
+  size_t allocationsBefore = allocations;
+  auto start = std::chrono::steady_clock::now();
+
+  while (halMillis() < duration) {
+    uint32_t now = halMillis();
+    level += ((unit.pump.on ? PUMP_FLOW_LPS : 0.0) - demandLps(now)) * stepSeconds;
+    level = level < 0 ? 0 : level > TANK_CAPACITY_L ? TANK_CAPACITY_L : level;
+    minLevel = level < minLevel ? level : minLevel;
+    maxLevel = level > maxLevel ? level : maxLevel;
+
+    double surface = level + ripple(now, seed);
+    simSetPin(SIM_LOW_PIN, surface >= TANK_LOW_FLOAT_L);
+    simSetPin(SIM_HIGH_PIN, surface >= TANK_HIGH_FLOAT_L);
+    simUnitStep(unit);
+  }
+
+  double replaySeconds = secondsSince(start);
+  size_t replayAllocations = allocations - allocationsBefore;
+  double simulatedHours = duration / 3600000.0;
+  printf("replay: %lu days in %.2f s (%.0fx real time)\n", (unsigned long)days, replaySeconds,
+         duration / 1000.0 / replaySeconds);
+  printf("replay: %lu fills, %lu relay changes (%.1f per hour), %lu decisions\n",
+         (unsigned long)unit.fills, (unsigned long)unit.switches, unit.switches / simulatedHours,
+         (unsigned long)unit.decisions);
+  printf("replay: level %.0f..%.0f L, %lu allocations\n", minLevel, maxLevel, (unsigned long)replayAllocations);
+
+  if (minLevel <= 0.0 || maxLevel >= TANK_CAPACITY_L) {
+    printf("FAIL tank ran dry or overflowed\n");
+    ok = false;
+  }
+  if (days > 0 && unit.fills == 0) {
+    printf("FAIL no fill completed\n");
+    ok = false;
+  }
+
+  // Decision latency: every float combination, override on and off, both schedule windows, the interlock, no flow, with the
+  // clock moving a task period per call so the min run/rest paths are hit.
+  const PumpInputs inputs[] = {
+    benchInputs(false, false),
+    benchInputs(true, false),
+    benchInputs(true, true),
+    benchInputs(false, true),
+    benchInputs(true, false, &PumpInputs::fault),
+    benchInputs(true, false, &PumpInputs::overrideMode, &PumpInputs::overrideState),
+    benchInputs(true, false, &PumpInputs::overrideMode),
+    benchInputs(true, false, &PumpInputs::topUp),
+    benchInputs(true, false, &PumpInputs::peak),
+    benchInputs(false, false, &PumpInputs::sourceLow),
+    benchInputs(false, false, &PumpInputs::noFlow),
+  };
+  const size_t inputCount = sizeof(inputs) / sizeof(inputs[0]);
+  const uint32_t iterations = 10000000;
+  PumpControl pump;
+  pumpControlBegin(pump, SIM_RELAY_PIN, true, SIM_MIN_RUN_MS, SIM_MIN_REST_MS);
+  uint32_t changes = 0;
+  allocationsBefore = allocations;
+  start = std::chrono::steady_clock::now();
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    simAdvance(SIM_TICK_MS);
+    PumpStep step = pumpControlUpdate(pump, inputs[(i / 64) % inputCount]);
+    changes += step.relayChanged;
+  }
+
+  double decisionSeconds = secondsSince(start);
+  size_t decisionAllocations = allocations - allocationsBefore;
+  printf("decision: %.1f ns mean over %lu calls (%lu relay changes), %lu allocations\n",
+         decisionSeconds * 1e9 / iterations, (unsigned long)iterations, (unsigned long)changes,
+         (unsigned long)decisionAllocations);
+
+  if (replayAllocations != 0 || decisionAllocations != 0) {
+    printf("FAIL control path allocated\n");
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
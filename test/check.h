@@ -0,0 +1,37 @@
+// Minimal assertions for the host tests. Each test binary calls its test
+// functions from main() and returns checkResult(), so ctest sees a non-zero
+// exit code if any check failed.
+#pragma once
+
+#include <stdio.h>
+
+inline int checkFailures = 0;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      checkFailures++; \
+    } \
+  } while (0)
+
+#define CHECK_EQ(actual, expected) \
+  do { \
+    long long a_ = (long long)(actual); \
+    long long e_ = (long long)(expected); \
+    if (a_ != e_) { \
+      fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #actual, #expected, a_, e_); \
+      checkFailures++; \
+    } \
+  } while (0)
+
+#define RUN_TEST(test) \
+  do { \
+    int before_ = checkFailures; \
+    test(); \
+    printf("%s %s\n", checkFailures == before_ ? "PASS" : "FAIL", #test); \
+  } while (0)
+
+inline int checkResult() {
+  return checkFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#include "sim_hal.h"
+#include "hal.h"
+
+static uint32_t simMillis = 0;
+static bool simPins[SIM_PIN_COUNT];
+static uint32_t simWrites[SIM_PIN_COUNT];
+
+void simReset() {
+  simMillis = 0;
+  for (int i = 0; i < SIM_PIN_COUNT; i++) {
+    simPins[i] = false;
+    simWrites[i] = 0;
+  }
+}
+
+void simAdvance(uint32_t ms) {
+  simMillis += ms;
+}
+
+void simSetMillis(uint32_t ms) {
+  simMillis = ms;
+}
+
+void simSetPin(uint8_t pin, bool high) {
+  simPins[pin % SIM_PIN_COUNT] = high;
+}
+
+bool simPin(uint8_t pin) {
+  return simPins[pin % SIM_PIN_COUNT];
+}
+
+uint32_t simPinWrites(uint8_t pin) {
+  return simWrites[pin % SIM_PIN_COUNT];
+}
+
+uint32_t halMillis() {
+  return simMillis;
+}
+
+bool halDigitalRead(uint8_t pin) {
+  return simPins[pin % SIM_PIN_COUNT];
+}
+
+void halDigitalWrite(uint8_t pin, bool high) {
+  simPins[pin % SIM_PIN_COUNT] = high;
+  simWrites[pin % SIM_PIN_COUNT]++;
+}
@@ -0,0 +1,15 @@
+// Simulated HAL: a clock that only moves when told to and a bank of pins the
+// tests set directly. Writes are counted per pin so tests can check the relay
+// is not re-driven needlessly.
+#pragma once
+
+#include <stdint.h>
+
+#define SIM_PIN_COUNT 32
+
+void simReset();
+void simAdvance(uint32_t ms);
+void simSetMillis(uint32_t ms);
+void simSetPin(uint8_t pin, bool high);
+bool simPin(uint8_t pin);
+uint32_t simPinWrites(uint8_t pin);
@@ -0,0 +1,115 @@
+#include "sim_script.h"
+#include "sim_hal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Chatter {
+  uint8_t pin;
+  uint32_t period;  // 0 = off
+  uint32_t nextAt;
+};
+
+static bool parseState(const char *name, PumpState &state) {
+  for (int i = PUMP_IDLE; i <= PUMP_INTERLOCK; i++) {
+    if (strcmp(name, PUMP_STATE_NAMES[i]) == 0) {
+      state = (PumpState)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void runUntil(SimUnit &unit, Chatter *chatter, uint32_t time) {
+  while (halMillis() < time) {
+    for (int i = 0; i < 2; i++) {
+      if (chatter[i].period > 0 && halMillis() >= chatter[i].nextAt) {
+        simSetPin(chatter[i].pin, !simPin(chatter[i].pin));
+        chatter[i].nextAt += chatter[i].period;
+      }
+    }
+    simUnitStep(unit);
+  }
+}
+
+bool runSensorScript(const char *path, SimUnit &unit) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return false;
+  }
+
+  // The unit boots on the first command that is not a pin level at time 0,
+  // so a script can start it with water already in the tank.
+  simReset();
+  bool started = false;
+  Chatter chatter[2] = { { SIM_LOW_PIN, 0, 0 }, { SIM_HIGH_PIN, 0, 0 } };
+  bool ok = true;
+  char line[128];
+
+  for (int number = 1; fgets(line, sizeof(line), file); number++) {
+    unsigned long time;
+    char command[16];
+    char arg[16] = "";
+    unsigned long value = 0;
+    if (line[0] == '#' || sscanf(line, "%lu %15s", &time, command) != 2) {
+      continue;
+    }
+    int args = sscanf(line, "%*u %*s %15s %lu", arg, &value);
+    bool pinLevel = strcmp(command, "low") == 0 || strcmp(command, "high") == 0;
+    if (!started && (time > 0 || !pinLevel)) {
+      simUnitBegin(unit);
+      started = true;
+    }
+    runUntil(unit, chatter, time);
+
+    Chatter *pinChatter = strcmp(arg, "low") == 0 ? &chatter[0] : strcmp(arg, "high") == 0 ? &chatter[1] : nullptr;
+    if (pinLevel) {
+      Chatter &c = command[0] == 'l' ? chatter[0] : chatter[1];
+      c.period = 0;
+      simSetPin(c.pin, strcmp(arg, "1") == 0);
+    } else if (strcmp(command, "chatter") == 0 && pinChatter && args == 2 && value > 0) {
+      pinChatter->period = value;
+      pinChatter->nextAt = halMillis();
+    } else if (strcmp(command, "override") == 0 && strcmp(arg, "AUTO") == 0) {
+      simUnitOverride(unit, false, false);
+    } else if (strcmp(command, "override") == 0 && (strcmp(arg, "ON") == 0 || strcmp(arg, "OFF") == 0)) {
+      simUnitOverride(unit, true, strcmp(arg, "ON") == 0);
+    } else if (strcmp(command, "window") == 0 && (strcmp(arg, "topup") == 0 || strcmp(arg, "peak") == 0 ||
+                                                  strcmp(arg, "none") == 0)) {
+      simUnitWindow(unit, strcmp(arg, "topup") == 0, strcmp(arg, "peak") == 0);
+    } else if (strcmp(command, "expect") == 0) {
+      PumpState state;
+      char relay[8] = "";
+      if (!parseState(arg, state) || sscanf(line, "%*u %*s %*s %7s", relay) != 1) {
+        fprintf(stderr, "%s:%d: bad expect\n", path, number);
+        ok = false;
+        continue;
+      }
+      bool on = strcmp(relay, "on") == 0;
+      if (unit.pump.state != state || unit.pump.on != on || simPin(SIM_RELAY_PIN) != on) {
+        fprintf(stderr, "%s:%d: expected %s %s, got %s %s\n", path, number, PUMP_STATE_NAMES[state],
+                relay, PUMP_STATE_NAMES[unit.pump.state], unit.pump.on ? "on" : "off");
+        ok = false;
+      }
+    } else if (strcmp(command, "switches") == 0) {
+      unsigned long expected = strtoul(arg, nullptr, 10);
+      if (unit.switches != expected) {
+        fprintf(stderr, "%s:%d: expected %lu relay changes, got %lu\n", path, number, expected,
+                (unsigned long)unit.switches);
+        ok = false;
+      }
+    } else {
+      fprintf(stderr, "%s:%d: bad command\n", path, number);
+      ok = false;
+    }
+  }
+
+  fclose(file);
+  if (!started) {
+    fprintf(stderr, "%s: no commands\n", path);
+    return false;
+  }
+  return ok;
+}
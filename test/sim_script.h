@@ -0,0 +1,19 @@
+// Sensor scripts drive a SimUnit through a timeline and check it on the way.
+// One command per line, times in ms since the start and never decreasing:
+//
+//   # comment
+//   <ms> low <0|1>                  set the low float pin (1 = WET)
+//   <ms> high <0|1>                 set the high float pin
+//   <ms> chatter <low|high> <ms>    toggle the pin at this period until the
+//                                   next low/high command for it
+//   <ms> override <ON|OFF|AUTO>     MQTT override command
+//   <ms> window <topup|peak|none>   schedule window opens (none: closes)
+//   <ms> expect <STATE> <on|off>    pump state and relay at this time
+//   <ms> switches <n>               relay changes so far
+#pragma once
+
+#include "sim_unit.h"
+
+// Runs the script at `path`. Reports each failed expectation on stderr and
+// returns false if any failed or the script could not be parsed.
+bool runSensorScript(const char *path, SimUnit &unit);
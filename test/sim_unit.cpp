@@ -0,0 +1,70 @@
+#include "sim_unit.h"
+#include "sim_hal.h"
+
+void simUnitBegin(SimUnit &unit) {
+  unit = SimUnit();
+  unit.filters[0].pin = SIM_LOW_PIN;
+  unit.filters[1].pin = SIM_HIGH_PIN;
+  for (SensorFilter &f : unit.filters) {
+    sensorFilterSeed(f, halDigitalRead(f.pin));
+  }
+  pumpControlBegin(unit.pump, SIM_RELAY_PIN, true, SIM_MIN_RUN_MS, SIM_MIN_REST_MS);
+  unit.pending = true;
+  unit.nextTickAt = halMillis();
+}
+
+static void simUnitTick(SimUnit &unit) {
+  bool low = sensorFilterRead(unit.filters, 2, SIM_LOW_PIN);
+  bool high = sensorFilterRead(unit.filters, 2, SIM_HIGH_PIN);
+  if (low != unit.low || high != unit.high) {
+    unit.low = low;
+    unit.high = high;
+    unit.pending = true;
+  }
+  if (!unit.pending) {
+    return;
+  }
+
+  PumpInputs inputs = {};
+  inputs.low = unit.low;
+  inputs.high = unit.high;
+  inputs.overrideMode = unit.overrideMode;
+  inputs.overrideState = unit.overrideState;
+  inputs.topUp = unit.topUp;
+  inputs.peak = unit.peak;
+  PumpStep step = pumpControlUpdate(unit.pump, inputs);
+  unit.decisions++;
+  if (step.deferred) {
+    return;
+  }
+  unit.pending = false;
+  if (step.stateChanged && step.previous == PUMP_FILLING && unit.pump.state == PUMP_FULL) {
+    unit.fills++;
+  }
+  if (step.relayChanged) {
+    unit.switches++;
+  }
+}
+
+void simUnitStep(SimUnit &unit) {
+  simAdvance(SIM_SAMPLE_MS);
+  for (SensorFilter &f : unit.filters) {
+    sensorFilterSample(f, halDigitalRead(f.pin));
+  }
+  if ((int32_t)(halMillis() - unit.nextTickAt) >= 0) {
+    unit.nextTickAt += SIM_TICK_MS;
+    simUnitTick(unit);
+  }
+}
+
+void simUnitWindow(SimUnit &unit, bool topUp, bool peak) {
+  unit.topUp = topUp;
+  unit.peak = peak;
+  unit.pending = true;
+}
+
+void simUnitOverride(SimUnit &unit, bool mode, bool state) {
+  unit.overrideMode = mode;
+  unit.overrideState = state;
+  unit.pending = true;
+}
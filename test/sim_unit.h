@@ -0,0 +1,44 @@
+// One simulated pump controller with float switches, wired the way the
+// sketch wires its float path: the sampler runs every SIM_SAMPLE_MS and the
+// sensors/pump tasks every SIM_TICK_MS, with the pump only re-evaluated after
+// a sensor edge or an override command.
+#pragma once
+
+#include <stdint.h>
+#include "pump_control.h"
+#include "sensor_filter.h"
+
+#define SIM_LOW_PIN 4
+#define SIM_HIGH_PIN 5
+#define SIM_RELAY_PIN 14
+#define SIM_SAMPLE_MS 5       // SAMPLE_INTERVAL_US in the sketch
+#define SIM_TICK_MS 50        // Period of the sensors and pump tasks
+#define SIM_MIN_RUN_MS 10000  // PUMP_MIN_RUN_MS
+#define SIM_MIN_REST_MS 30000 // PUMP_MIN_REST_MS
+
+struct SimUnit {
+  SensorFilter filters[2];
+  PumpControl pump;
+  bool low;
+  bool high;
+  bool overrideMode;
+  bool overrideState;
+  bool topUp;
+  bool peak;
+  bool pending;
+  uint32_t nextTickAt;
+  uint32_t decisions;  // pumpControlUpdate() calls
+  uint32_t switches;   // Relay changes
+  uint32_t fills;      // FILLING -> FULL transitions
+};
+
+// Resets the simulated HAL and seeds the filters from the current pins.
+void simUnitBegin(SimUnit &unit);
+
+// Advances the clock by one sampler period and runs whatever is due.
+void simUnitStep(SimUnit &unit);
+
+void simUnitOverride(SimUnit &unit, bool mode, bool state);
+
+// Opens or closes a schedule window, as the sketch's schedule task does.
+void simUnitWindow(SimUnit &unit, bool topUp, bool peak);
@@ -0,0 +1,58 @@
+#include "check.h"
+#include "board_profiles.h"
+
+static_assert(boardProfileValid(BOARD_NODEMCU_V2), "");
+static_assert(boardProfileValid(BOARD_NODEMCU_V2_ACTIVE_LOW), "");
+static_assert(boardProfileValid(BOARD_D1_MINI), "");
+static_assert(boardProfileValid(BOARD_ESP32_DEVKIT), "");
+
+static void testDefaultIsOriginalWiring() {
+  CHECK(&BOARD == &BOARD_NODEMCU_V2);
+  CHECK_EQ(BOARD.lowSensorPin, 4);
+  CHECK_EQ(BOARD.highSensorPin, 5);
+  CHECK_EQ(BOARD.relayPin, 14);
+  CHECK(BOARD.relayActiveHigh);
+}
+
+static void testRejectsFlashPins() {
+  BoardProfile board = BOARD_NODEMCU_V2;
+  board.relayPin = 6;
+  CHECK(!boardProfileValid(board));
+  board.relayPin = 11;
+  CHECK(!boardProfileValid(board));
+  board.relayPin = 17;
+  CHECK(!boardProfileValid(board));
+}
+
+static void testEsp32PinRules() {
+  BoardProfile board = BOARD_ESP32_DEVKIT;
+  CHECK(!boardUltrasonicShared(board));
+  board.relayPin = 9;
+  CHECK(!boardProfileValid(board));
+  board.relayPin = 34;  // Input-only
+  CHECK(!boardProfileValid(board));
+  board = BOARD_ESP32_DEVKIT;
+  board.highSensorPin = 34;  // Fine for an input
+  CHECK(boardProfileValid(board));
+  board.chip = CHIP_ESP8266;  // But not on the ESP8266
+  CHECK(!boardProfileValid(board));
+  CHECK(boardUltrasonicShared(BOARD_NODEMCU_V2));
+}
+
+static void testRejectsSharedPins() {
+  BoardProfile board = BOARD_NODEMCU_V2;
+  board.flowMeterPin = board.lowSensorPin;
+  CHECK(!boardProfileValid(board));
+
+  board = BOARD_NODEMCU_V2;
+  board.roofRelayPin = BOARD_NO_PIN;  // Unwired is fine, and so is the ultrasonic sharing the roof pins
+  CHECK(boardProfileValid(board));
+}
+
+int main() {
+  RUN_TEST(testDefaultIsOriginalWiring);
+  RUN_TEST(testRejectsFlashPins);
+  RUN_TEST(testEsp32PinRules);
+  RUN_TEST(testRejectsSharedPins);
+  return checkResult();
+}
@@ -0,0 +1,162 @@
+#include "check.h"
+#include "config_store.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// Stored record in memory, read back through the same ConfigReader the
+// sketch uses for LittleFS files.
+struct Buffer {
+  uint8_t data[512];
+  size_t size;
+  size_t position;
+};
+
+static size_t readBuffer(void *context, uint8_t *out, size_t length) {
+  Buffer &buffer = *(Buffer *)context;
+  size_t n = buffer.size - buffer.position < length ? buffer.size - buffer.position : length;
+  memcpy(out, buffer.data + buffer.position, n);
+  buffer.position += n;
+  return n;
+}
+
+static void append(Buffer &buffer, const void *data, size_t length) {
+  memcpy(buffer.data + buffer.size, data, length);
+  buffer.size += length;
+}
+
+static Config sample() {
+  Config config = CONFIG_DEFAULTS;
+  strcpy(config.wifi_ssid, "tank-net");
+  strcpy(config.mqtt_server, "10.0.0.2");
+  config.mqtt_port = 8883;
+  config.level_stop = 90;
+  return config;
+}
+
+static Buffer save(const Config &config, uint32_t sequence) {
+  Buffer buffer = {};
+  ConfigHeader header = configMakeHeader(config, sequence);
+  append(buffer, &header, sizeof(header));
+  append(buffer, &config, sizeof(config));
+  return buffer;
+}
+
+static bool load(Buffer &buffer, Config &out, uint32_t &sequence) {
+  buffer.position = 0;
+  out = CONFIG_DEFAULTS;
+  return configReadRecord(readBuffer, &buffer, out, sequence);
+}
+
+static void testRoundTrip() {
+  Config saved = sample();
+  Buffer buffer = save(saved, 7);
+  Config loaded;
+  uint32_t sequence = 0;
+  CHECK(load(buffer, loaded, sequence));
+  CHECK_EQ(sequence, 7);
+  CHECK(memcmp(&saved, &loaded, sizeof(Config)) == 0);
+}
+
+static void testRejectsCorruption() {
+  Buffer buffer = save(sample(), 1);
+  Config loaded;
+  uint32_t sequence = 0;
+  for (size_t i = 0; i < buffer.size; i++) {
+    if (i >= 4 && i < 12) {
+      continue;  // Version, length and sequence sit outside the CRC
+    }
+    buffer.data[i] ^= 0x10;
+    CHECK(!load(buffer, loaded, sequence));
+    CHECK(memcmp(&loaded, &CONFIG_DEFAULTS, sizeof(Config)) == 0);
+    buffer.data[i] ^= 0x10;
+  }
+}
+
+static void testRejectsTruncation() {
+  Buffer buffer = save(sample(), 1);
+  Config loaded;
+  uint32_t sequence = 0;
+  buffer.size -= 1;
+  CHECK(!load(buffer, loaded, sequence));
+  buffer.size = sizeof(ConfigHeader) - 1;
+  CHECK(!load(buffer, loaded, sequence));
+  buffer.size = 0;
+  CHECK(!load(buffer, loaded, sequence));
+}
+
+static void testShorterRecordKeepsDefaultTail() {
+  Config old = sample();
+  const size_t oldLength = offsetof(Config, sensor_type);  // Before the level sensor fields
+  ConfigHeader header = configMakeHeader(old, 3);
+  header.length = oldLength;
+  header.crc = ~crc32Update(0xFFFFFFFFUL, &old, oldLength);
+  Buffer buffer = {};
+  append(buffer, &header, sizeof(header));
+  append(buffer, &old, oldLength);
+
+  Config loaded;
+  uint32_t sequence = 0;
+  CHECK(load(buffer, loaded, sequence));
+  CHECK(strcmp(loaded.wifi_ssid, "tank-net") == 0);
+  CHECK_EQ(loaded.level_stop, CONFIG_DEFAULTS.level_stop);
+  CHECK_EQ(loaded.cal_full, CONFIG_DEFAULTS.cal_full);
+  CHECK_EQ(loaded.power_latency_ms, CONFIG_DEFAULTS.power_latency_ms);
+  CHECK(strcmp(loaded.mqtt_prefix, "waterpump") == 0);
+  CHECK_EQ(loaded.mqtt_tls, 0);
+  CHECK_EQ(loaded.flow_pulses_per_litre, 0);
+}
+
+static void testLongerRecordIsAccepted() {
+  Config saved = sample();
+  const uint8_t extra[40] = { 1, 2, 3 };
+  ConfigHeader header = configMakeHeader(saved, 9);
+  header.length = sizeof(Config) + sizeof(extra);
+  header.crc = ~crc32Update(crc32Update(0xFFFFFFFFUL, &saved, sizeof(Config)), extra, sizeof(extra));
+  Buffer buffer = {};
+  append(buffer, &header, sizeof(header));
+  append(buffer, &saved, sizeof(saved));
+  append(buffer, extra, sizeof(extra));
+
+  Config loaded;
+  uint32_t sequence = 0;
+  CHECK(load(buffer, loaded, sequence));
+  CHECK(memcmp(&saved, &loaded, sizeof(Config)) == 0);
+
+  buffer.size -= 1;  // Tail cut short
+  CHECK(!load(buffer, loaded, sequence));
+}
+
+static void testCrcKnownValue() {
+  CHECK_EQ(~crc32Update(0xFFFFFFFFUL, "123456789", 9), 0xCBF43926UL);
+}
+
+static void testLegacyValidation() {
+  Config legacy = sample();
+  CHECK(configLegacyValid(legacy));
+
+  Config blank;
+  memset(&blank, 0xFF, sizeof(blank));
+  CHECK(!configLegacyValid(blank));
+
+  legacy.mqtt_port = 0;
+  CHECK(!configLegacyValid(legacy));
+  legacy = sample();
+  legacy.wifi_ssid[0] = '\0';
+  legacy.mqtt_server[0] = '\0';
+  CHECK(!configLegacyValid(legacy));
+  legacy = sample();
+  memset(legacy.mqtt_user, 'a', sizeof(legacy.mqtt_user));  // No terminator
+  CHECK(!configLegacyValid(legacy));
+}
+
+int main() {
+  RUN_TEST(testRoundTrip);
+  RUN_TEST(testRejectsCorruption);
+  RUN_TEST(testRejectsTruncation);
+  RUN_TEST(testShorterRecordKeepsDefaultTail);
+  RUN_TEST(testLongerRecordIsAccepted);
+  RUN_TEST(testCrcKnownValue);
+  RUN_TEST(testLegacyValidation);
+  return checkResult();
+}
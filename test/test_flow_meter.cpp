@@ -0,0 +1,106 @@
+#include "check.h"
+#include "flow_meter.h"
+
+#define PRIME_MS 10000
+#define NO_FLOW_MS 5000
+#define RETRY_MS 60000
+#define TICK_MS 250
+
+static FlowMeter meter(uint32_t now) {
+  FlowMeter m;
+  flowMeterBegin(m, 450, PRIME_MS, NO_FLOW_MS, RETRY_MS, 0, now);
+  return m;
+}
+
+static void testRateAndCycleVolume() {
+  FlowMeter m = meter(0);
+  uint32_t count = 0;
+  FlowTick tick = {};
+  for (uint32_t now = TICK_MS; now <= 60000; now += TICK_MS) {
+    count += 15;  // 60 pulses/s at 450 pulses/L: 8 L/min
+    tick = flowMeterTick(m, count, now, true);
+    CHECK(!tick.faultRaised);
+  }
+  CHECK(m.rateMlPerMin > 7900 && m.rateMlPerMin <= 8000);
+  tick = flowMeterTick(m, count, 60000 + TICK_MS, false);
+  CHECK(tick.cycleEnded);
+  CHECK_EQ(tick.cycleMl, 8000);
+  CHECK_EQ(flowMeterMillilitres(m, m.totalPulses), 8000);
+}
+
+static void testNoFlowFaultAfterPriming() {
+  FlowMeter m = meter(0);
+  uint32_t now = 0;
+  bool raised = false;
+  while (!raised && now < 60000) {
+    now += TICK_MS;
+    raised = flowMeterTick(m, 0, now, true).faultRaised;
+  }
+  CHECK(raised);
+  CHECK_EQ(now, TICK_MS + PRIME_MS + NO_FLOW_MS);  // The first ON tick starts the prime time
+  CHECK(m.fault);
+}
+
+static void testFlowStoppingMidRunFaults() {
+  FlowMeter m = meter(0);
+  uint32_t count = 0;
+  uint32_t now = 0;
+  for (; now < 20000; now += TICK_MS) {
+    count += 10;
+    CHECK(!flowMeterTick(m, count, now, true).faultRaised);
+  }
+  uint32_t stalledAt = now - TICK_MS;
+  bool raised = false;
+  for (; !raised && now < 40000; now += TICK_MS) {
+    raised = flowMeterTick(m, count, now, true).faultRaised;
+  }
+  CHECK(raised);
+  CHECK_EQ(now - TICK_MS - stalledAt, NO_FLOW_MS);
+}
+
+static void testFaultLatchesThenRetries() {
+  FlowMeter m = meter(0);
+  uint32_t now = 0;
+  while (!m.fault) {
+    now += TICK_MS;
+    flowMeterTick(m, 0, now, true);
+  }
+  uint32_t faultAt = now;
+  FlowTick tick = {};
+  for (now += TICK_MS; now - faultAt < RETRY_MS; now += TICK_MS) {
+    tick = flowMeterTick(m, 0, now, false);  // Pump held off by the fault
+    CHECK(!tick.faultCleared);
+    CHECK(m.fault);
+  }
+  tick = flowMeterTick(m, 0, now, false);
+  CHECK(tick.faultCleared);
+  CHECK(!m.fault);
+
+  FlowMeter cleared = meter(0);
+  cleared.fault = true;
+  flowMeterClearFault(cleared);
+  CHECK(!cleared.fault);
+}
+
+static void testCounterWrapAndNoMeter() {
+  FlowMeter m;
+  flowMeterBegin(m, 450, PRIME_MS, NO_FLOW_MS, RETRY_MS, 0xFFFFFFF0UL, 0);
+  flowMeterTick(m, 0x00000010UL, TICK_MS, true);
+  CHECK_EQ(m.totalPulses, 32);
+
+  FlowMeter none;
+  flowMeterBegin(none, 0, PRIME_MS, NO_FLOW_MS, RETRY_MS, 0, 0);
+  for (uint32_t now = TICK_MS; now < 60000; now += TICK_MS) {
+    CHECK(!flowMeterTick(none, 0, now, true).faultRaised);
+  }
+  CHECK_EQ(flowMeterMillilitres(none, 100), 0);
+}
+
+int main() {
+  RUN_TEST(testRateAndCycleVolume);
+  RUN_TEST(testNoFlowFaultAfterPriming);
+  RUN_TEST(testFlowStoppingMidRunFaults);
+  RUN_TEST(testFaultLatchesThenRetries);
+  RUN_TEST(testCounterWrapAndNoMeter);
+  return checkResult();
+}
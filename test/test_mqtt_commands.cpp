@@ -0,0 +1,91 @@
+#include "check.h"
+#include "mqtt_commands.h"
+
+#include <string.h>
+
+static int overrideCalls = 0;
+static int ledCalls = 0;
+static char lastPayload[16];
+
+static bool onOverride(const uint8_t *payload, unsigned int length) {
+  overrideCalls++;
+  memcpy(lastPayload, payload, length);
+  lastPayload[length] = '\0';
+  return payloadIs(payload, length, "ON") || payloadIs(payload, length, "OFF");
+}
+
+static bool onLed(const uint8_t *, unsigned int) {
+  ledCalls++;
+  return true;
+}
+
+constexpr MqttRoute ROUTES[] = {
+  MQTT_ROUTE("override", onOverride),
+  MQTT_ROUTE("led", onLed),
+};
+
+static_assert(topicHash("") == 2166136261u, "topicHash is usable at compile time");
+static_assert(ROUTES[0].hash != ROUTES[1].hash, "route hashes differ");
+
+static MqttResult dispatch(const char *topic, const char *payload) {
+  return mqttDispatch(ROUTES, 2, "waterpump/", topic, (const uint8_t *)payload, strlen(payload));
+}
+
+static void testDispatchesToRoute() {
+  overrideCalls = ledCalls = 0;
+  CHECK(dispatch("waterpump/override", "ON"));
+  CHECK_EQ(overrideCalls, 1);
+  CHECK(strcmp(lastPayload, "ON") == 0);
+  CHECK(dispatch("waterpump/led", ""));
+  CHECK_EQ(ledCalls, 1);
+}
+
+static void testReportsRejectedCommands() {
+  overrideCalls = 0;
+  CHECK_EQ(dispatch("waterpump/override", "OFF"), MQTT_ACCEPTED);
+  CHECK_EQ(dispatch("waterpump/override", "MAYBE"), MQTT_REJECTED);
+  CHECK_EQ(overrideCalls, 2);
+  CHECK_EQ(dispatch("waterpump/unknown", "ON"), MQTT_NO_ROUTE);
+}
+
+static void testIgnoresForeignTopics() {
+  overrideCalls = ledCalls = 0;
+  CHECK(!dispatch("otherpump/override", "ON"));
+  CHECK(!dispatch("waterpump/overridex", "ON"));
+  CHECK(!dispatch("waterpump/", "ON"));
+  CHECK(!dispatch("waterpump", "ON"));
+  CHECK_EQ(overrideCalls + ledCalls, 0);
+}
+
+static void testHashMatchesRuntime() {
+  char suffix[] = "override";
+  CHECK_EQ(topicHash(suffix), ROUTES[0].hash);
+}
+
+static void testTopicNames() {
+  CHECK(mqttTopicNameValid("waterpump", false));
+  CHECK(mqttTopicNameValid("site-4/pumps", true));
+  CHECK(!mqttTopicNameValid("site-4/pumps", false));
+  const char *bad[] = { "", "/pumps", "pumps/", "site//pumps", "pumps/#", "a+b", "two words" };
+  for (const char *name : bad) {
+    CHECK(!mqttTopicNameValid(name, true));
+  }
+}
+
+static void testPayloadIs() {
+  const uint8_t payload[] = { 'O', 'N', 'X' };  // Not NUL-terminated
+  CHECK(payloadIs(payload, 2, "ON"));
+  CHECK(!payloadIs(payload, 3, "ON"));
+  CHECK(!payloadIs(payload, 1, "ON"));
+  CHECK(payloadIs(payload, 0, ""));
+}
+
+int main() {
+  RUN_TEST(testDispatchesToRoute);
+  RUN_TEST(testIgnoresForeignTopics);
+  RUN_TEST(testReportsRejectedCommands);
+  RUN_TEST(testHashMatchesRuntime);
+  RUN_TEST(testTopicNames);
+  RUN_TEST(testPayloadIs);
+  return checkResult();
+}
@@ -0,0 +1,109 @@
+#include "check.h"
+#include "ota_manifest.h"
+
+#include <string.h>
+
+static const char MD5[] = "0123456789abcdef0123456789ABCDEF";
+static const char SHA256[] = "00112233445566778899aabbccddeeff00112233445566778899AABBCCDDEEFF";
+
+#define SHA "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+#define SHA_OLD "fedcba9876543210fedcba9876543210fedcba9876543210fedcba9876543210"
+
+static const char MANIFEST[] =
+  "version=1.4.0\n"
+  "url=http://updates.local/watertank-1.4.0.bin.gz\n"
+  "md5=0123456789abcdef0123456789ABCDEF\n"
+  "sha256=00112233445566778899aabbccddeeff00112233445566778899AABBCCDDEEFF\n"
+  "sig=a1b2c3\n";
+
+static void testParsesRequiredFields() {
+  OtaManifest m;
+  CHECK(otaParseManifest(MANIFEST, m));
+  CHECK(strcmp(m.version, "1.4.0") == 0);
+  CHECK(strcmp(m.url, "http://updates.local/watertank-1.4.0.bin.gz") == 0);
+  CHECK(strcmp(m.md5, MD5) == 0);
+  CHECK(strcmp(m.sha256, SHA256) == 0);
+  CHECK_EQ(m.rollbackUrl[0], '\0');
+  CHECK_EQ(m.signatureLength, 6);
+  CHECK(strncmp(m.signature, "a1b2c3", 6) == 0);
+  CHECK_EQ(m.signedLength, strstr(MANIFEST, "sig=") - MANIFEST);
+}
+
+static void testParsesRollbackAndCrlf() {
+  OtaManifest m;
+  CHECK(otaParseManifest("version=2\r\nurl=http://a/b\r\nmd5=0123456789abcdef0123456789abcdef\r\n"
+                         "sha256=" SHA "\r\n"
+                         "rollback_url=http://a/old\r\nrollback_md5=fedcba9876543210fedcba9876543210\r\n"
+                         "rollback_sha256=" SHA_OLD "\r\n"
+                         "channel=beta\r\nsig=00ff\r\n", m));
+  CHECK(strcmp(m.rollbackUrl, "http://a/old") == 0);
+  CHECK(strcmp(m.rollbackMd5, "fedcba9876543210fedcba9876543210") == 0);
+  CHECK(strcmp(m.rollbackSha256, SHA_OLD) == 0);
+  CHECK(strcmp(m.url, "http://a/b") == 0);
+  CHECK_EQ(m.signatureLength, 4);
+}
+
+static void testRejectsBadManifests() {
+  OtaManifest m;
+  // No signature
+  CHECK(!otaParseManifest("version=1\nurl=http://a\nmd5=0123456789abcdef0123456789abcdef\nsha256=" SHA "\n", m));
+  // Missing url
+  CHECK(!otaParseManifest("version=1\nmd5=0123456789abcdef0123456789abcdef\nsha256=" SHA "\nsig=00\n", m));
+  // Short md5
+  CHECK(!otaParseManifest("version=1\nurl=http://a\nmd5=0123\nsha256=" SHA "\nsig=00\n", m));
+  // Non-hex md5
+  CHECK(!otaParseManifest("version=1\nurl=http://a\nmd5=0123456789abcdef0123456789abcdeg\nsha256=" SHA "\nsig=00\n", m));
+  // Content after the signature is not covered by it
+  CHECK(!otaParseManifest("version=1\nurl=http://a\nmd5=0123456789abcdef0123456789abcdef\nsha256=" SHA "\nsig=00\nurl=http://evil\n", m));
+  // Rollback url without its md5
+  CHECK(!otaParseManifest("version=1\nurl=http://a\nmd5=0123456789abcdef0123456789abcdef\nsha256=" SHA "\nrollback_url=http://b\n"
+                          "rollback_sha256=" SHA_OLD "\nsig=00\n", m));
+  // Rollback url without its sha256
+  CHECK(!otaParseManifest("version=1\nurl=http://a\nmd5=0123456789abcdef0123456789abcdef\nsha256=" SHA "\nrollback_url=http://b\n"
+                          "rollback_md5=fedcba9876543210fedcba9876543210\nsig=00\n", m));
+  // No sha256
+  CHECK(!otaParseManifest("version=1\nurl=http://a\nmd5=0123456789abcdef0123456789abcdef\nsig=00\n", m));
+  // Short sha256
+  CHECK(!otaParseManifest("version=1\nurl=http://a\nmd5=0123456789abcdef0123456789abcdef\nsha256=0123456789abcdef\nsig=00\n", m));
+  // Version not dotted decimal
+  CHECK(!otaParseManifest("version=1.4-beta\nurl=http://a\nmd5=0123456789abcdef0123456789abcdef\nsha256=" SHA "\nsig=00\n", m));
+  // Line without '='
+  CHECK(!otaParseManifest("version=1\ngarbage\nurl=http://a\nmd5=0123456789abcdef0123456789abcdef\nsha256=" SHA "\nsig=00\n", m));
+  // Version too long for the field
+  CHECK(!otaParseManifest("version=12345678901234567\nurl=http://a\nmd5=0123456789abcdef0123456789abcdef\nsha256=" SHA "\nsig=00\n", m));
+}
+
+static void testHexDecode() {
+  uint8_t out[4];
+  CHECK_EQ(hexDecode("00ff7A", 6, out, sizeof(out)), 3);
+  CHECK_EQ(out[0], 0x00);
+  CHECK_EQ(out[1], 0xff);
+  CHECK_EQ(out[2], 0x7a);
+  CHECK_EQ(hexDecode("abc", 3, out, sizeof(out)), 0);
+  CHECK_EQ(hexDecode("zz", 2, out, sizeof(out)), 0);
+  CHECK_EQ(hexDecode("0011223344", 10, out, sizeof(out)), 0);
+}
+
+static void testVersionOrder() {
+  CHECK(otaVersionNewer("1.4.0", "1.3.2"));
+  CHECK(otaVersionNewer("1.10.0", "1.9.9"));  // Numeric, not text order
+  CHECK(otaVersionNewer("2", "1.99"));
+  CHECK(otaVersionNewer("1.4.1", "1.4"));
+  CHECK(!otaVersionNewer("1.4.0", "1.4.0"));
+  CHECK(!otaVersionNewer("1.4", "1.4.0"));
+  CHECK(!otaVersionNewer("1.3.9", "1.4.0"));  // Downgrade
+  CHECK(!otaVersionNewer("1.5.0", "1.4.0-dev"));
+  CHECK(!otaVersionNewer("1..5", "1.4"));
+  CHECK(!otaVersionNewer("1.5.", "1.4"));
+  CHECK(!otaVersionNewer("", "1.4"));
+  CHECK(!otaVersionNewer("99999999999", "1"));
+}
+
+int main() {
+  RUN_TEST(testParsesRequiredFields);
+  RUN_TEST(testParsesRollbackAndCrlf);
+  RUN_TEST(testRejectsBadManifests);
+  RUN_TEST(testVersionOrder);
+  RUN_TEST(testHexDecode);
+  return checkResult();
+}
@@ -0,0 +1,251 @@
+#include "check.h"
+#include "pump_control.h"
+#include "sim_hal.h"
+
+#define RELAY 14
+
+static PumpControl begin() {
+  simReset();
+  simSetMillis(1000);
+  PumpControl pump;
+  pumpControlBegin(pump, RELAY, true, 10000, 30000);
+  return pump;
+}
+
+// Everything but the floats off, including any input added later.
+static PumpInputs floats(bool low, bool high) {
+  PumpInputs in = {};
+  in.low = low;
+  in.high = high;
+  return in;
+}
+
+static void testNextState() {
+  PumpControl pump = begin();
+  CHECK_EQ(pumpNextState(pump, floats(false, false)), PUMP_FILLING);
+  CHECK_EQ(pumpNextState(pump, floats(true, false)), PUMP_IDLE);
+  CHECK_EQ(pumpNextState(pump, floats(true, true)), PUMP_FULL);
+  CHECK_EQ(pumpNextState(pump, floats(false, true)), PUMP_FAULT);
+  PumpInputs in = floats(true, false);
+  in.fault = true;
+  CHECK_EQ(pumpNextState(pump, in), PUMP_FAULT);
+  in.high = true;
+  in.overrideMode = true;
+  CHECK_EQ(pumpNextState(pump, in), PUMP_OVERRIDE);
+  pump.on = true;
+  CHECK_EQ(pumpNextState(pump, floats(true, false)), PUMP_FILLING);
+}
+
+static void testBeginDrivesRelayOff() {
+  simReset();
+  simSetPin(RELAY, true);
+  PumpControl pump;
+  pumpControlBegin(pump, RELAY, true, 10000, 30000);
+  CHECK(!simPin(RELAY));
+  CHECK(!pump.on);
+  CHECK_EQ(pump.state, PUMP_IDLE);
+}
+
+static void testFillCycle() {
+  PumpControl pump = begin();
+  PumpStep step = pumpControlUpdate(pump, floats(false, false));
+  CHECK(!step.deferred);
+  CHECK(step.stateChanged);
+  CHECK(step.relayChanged);
+  CHECK(simPin(RELAY));
+
+  simAdvance(60000);
+  step = pumpControlUpdate(pump, floats(true, false));
+  CHECK(!step.stateChanged);
+  CHECK(!step.relayChanged);
+  CHECK(pump.on);
+
+  step = pumpControlUpdate(pump, floats(true, true));
+  CHECK_EQ(step.previous, PUMP_FILLING);
+  CHECK_EQ(pump.state, PUMP_FULL);
+  CHECK(!simPin(RELAY));
+}
+
+static void testActiveLowRelay() {
+  simReset();
+  PumpControl pump;
+  pumpControlBegin(pump, RELAY, false, 10000, 30000);
+  CHECK(simPin(RELAY));  // OFF is HIGH
+  pumpControlUpdate(pump, floats(false, false));
+  CHECK(pump.on);
+  CHECK(!simPin(RELAY));
+}
+
+static void testRelayWrittenOnlyOnChange() {
+  PumpControl pump = begin();
+  uint32_t writes = simPinWrites(RELAY);
+  for (int i = 0; i < 100; i++) {
+    pumpControlUpdate(pump, floats(true, false));
+  }
+  CHECK_EQ(simPinWrites(RELAY), writes);
+}
+
+static void testMinRunHoldsPumpOn() {
+  PumpControl pump = begin();
+  pumpControlUpdate(pump, floats(false, false));
+  simAdvance(5000);
+  PumpStep step = pumpControlUpdate(pump, floats(true, true));
+  CHECK(step.deferred);
+  CHECK(pump.on);
+  CHECK_EQ(pump.state, PUMP_FILLING);
+  simAdvance(5000);
+  step = pumpControlUpdate(pump, floats(true, true));
+  CHECK(!step.deferred);
+  CHECK(!pump.on);
+}
+
+static void testMinRestHoldsPumpOff() {
+  PumpControl pump = begin();
+  pumpControlUpdate(pump, floats(false, false));
+  simAdvance(20000);
+  pumpControlUpdate(pump, floats(true, true));
+  simAdvance(29999);
+  CHECK(pumpControlUpdate(pump, floats(false, false)).deferred);
+  simAdvance(1);
+  CHECK(pumpControlUpdate(pump, floats(false, false)).relayChanged);
+  CHECK(pump.on);
+}
+
+static void testFirstSwitchIsNotDelayed() {
+  simReset();
+  PumpControl pump;
+  pumpControlBegin(pump, RELAY, true, 10000, 30000);
+  CHECK(pumpControlUpdate(pump, floats(false, false)).relayChanged);
+}
+
+static void testFaultAndOverrideSkipMinTimes() {
+  PumpControl pump = begin();
+  pumpControlUpdate(pump, floats(false, false));
+  simAdvance(100);
+  PumpStep step = pumpControlUpdate(pump, floats(false, true));
+  CHECK(!step.deferred);
+  CHECK_EQ(pump.state, PUMP_FAULT);
+  CHECK(!simPin(RELAY));
+
+  simAdvance(100);
+  PumpInputs in = floats(true, true);
+  in.overrideMode = true;
+  in.overrideState = true;
+  step = pumpControlUpdate(pump, in);
+  CHECK(!step.deferred);
+  CHECK_EQ(pump.state, PUMP_OVERRIDE);
+  CHECK(simPin(RELAY));
+}
+
+static void testMillisWraparound() {
+  simReset();
+  simSetMillis(0xFFFFF000UL);
+  PumpControl pump;
+  pumpControlBegin(pump, RELAY, true, 10000, 30000);
+  pumpControlUpdate(pump, floats(false, false));
+  simAdvance(5000);  // Wraps past zero
+  CHECK(pumpControlUpdate(pump, floats(true, true)).deferred);
+  simAdvance(5000);
+  CHECK(!pumpControlUpdate(pump, floats(true, true)).deferred);
+}
+
+static PumpInputs window(bool low, bool high, bool topUp, bool peak) {
+  PumpInputs in = floats(low, high);
+  in.topUp = topUp;
+  in.peak = peak;
+  return in;
+}
+
+static void testTopUpFillsOncePerWindow() {
+  PumpControl pump = begin();
+  CHECK(pumpControlUpdate(pump, window(true, false, true, false)).relayChanged);
+  CHECK_EQ(pump.state, PUMP_FILLING);
+  simAdvance(60000);
+  pumpControlUpdate(pump, window(true, true, true, false));
+  CHECK_EQ(pump.state, PUMP_FULL);
+
+  // Drawn down below the high float, still inside the window: no second fill
+  simAdvance(60000);
+  pumpControlUpdate(pump, window(true, false, true, false));
+  CHECK_EQ(pump.state, PUMP_IDLE);
+  CHECK(!pump.on);
+
+  // The next window tops up again
+  pumpControlUpdate(pump, floats(true, false));
+  pumpControlUpdate(pump, window(true, false, true, false));
+  CHECK(pump.on);
+}
+
+static void testPeakStopsAtLowFloat() {
+  PumpControl pump = begin();
+  CHECK(pumpControlUpdate(pump, window(false, false, false, true)).relayChanged);  // Empty still fills
+  simAdvance(20000);
+  pumpControlUpdate(pump, window(true, false, false, true));
+  CHECK_EQ(pump.state, PUMP_IDLE);
+  CHECK(!pump.on);
+  CHECK_EQ(pumpNextState(pump, window(true, false, true, true)), PUMP_IDLE);
+}
+
+static void testInterlockHoldsAndResumesFill() {
+  PumpControl pump = begin();
+  PumpInputs in = floats(false, false);
+  pumpControlUpdate(pump, in);
+  CHECK(pump.on);
+
+  simAdvance(1000);  // Well inside the minimum run time
+  in.sourceLow = true;
+  PumpStep step = pumpControlUpdate(pump, in);
+  CHECK(!step.deferred);
+  CHECK_EQ(pump.state, PUMP_INTERLOCK);
+  CHECK(!simPin(RELAY));
+
+  // Source recovers with this tank between the floats: the fill resumes
+  simAdvance(30000);
+  in = floats(true, false);
+  pumpControlUpdate(pump, in);
+  CHECK_EQ(pump.state, PUMP_FILLING);
+  CHECK(pump.on);
+
+  // A full tank is not interlocked
+  in = floats(true, true);
+  in.sourceLow = true;
+  CHECK_EQ(pumpNextState(pump, in), PUMP_FULL);
+  in.overrideMode = true;
+  CHECK_EQ(pumpNextState(pump, in), PUMP_OVERRIDE);
+}
+
+static void testNoFlowStopsPumpAtOnce() {
+  PumpControl pump = begin();
+  PumpInputs in = floats(false, false);
+  pumpControlUpdate(pump, in);
+  CHECK(pump.on);
+
+  simAdvance(1000);  // Inside the minimum run time
+  in.noFlow = true;
+  PumpStep step = pumpControlUpdate(pump, in);
+  CHECK(!step.deferred);
+  CHECK_EQ(pump.state, PUMP_FAULT);
+  CHECK(!simPin(RELAY));
+
+  in.overrideMode = true;  // A manual override still runs it
+  in.overrideState = true;
+  CHECK_EQ(pumpNextState(pump, in), PUMP_OVERRIDE);
+}
+
+int main() {
+  RUN_TEST(testNextState);
+  RUN_TEST(testBeginDrivesRelayOff);
+  RUN_TEST(testFillCycle);
+  RUN_TEST(testActiveLowRelay);
+  RUN_TEST(testRelayWrittenOnlyOnChange);
+  RUN_TEST(testMinRunHoldsPumpOn);
+  RUN_TEST(testMinRestHoldsPumpOff);
+  RUN_TEST(testFirstSwitchIsNotDelayed);
+  RUN_TEST(testFaultAndOverrideSkipMinTimes);
+  RUN_TEST(testMillisWraparound);
+  RUN_TEST(testTopUpFillsOncePerWindow);
+  RUN_TEST(testPeakStopsAtLowFloat);
+  RUN_TEST(testInterlockHoldsAndResumesFill);
+  RUN_TEST(testNoFlowStopsPumpAtOnce);
+  return checkResult();
+}
@@ -0,0 +1,15 @@
+// Replays each sensor script named on the command line, see sim_script.h.
+#include <stdio.h>
+#include "sim_script.h"
+
+int main(int argc, char **argv) {
+  int failures = 0;
+  for (int i = 1; i < argc; i++) {
+    SimUnit unit;
+    bool ok = runSensorScript(argv[i], unit);
+    printf("%s %s (%lu decisions, %lu relay changes)\n", ok ? "PASS" : "FAIL", argv[i],
+           (unsigned long)unit.decisions, (unsigned long)unit.switches);
+    failures += ok ? 0 : 1;
+  }
+  return failures == 0 ? 0 : 1;
+}
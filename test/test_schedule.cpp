@@ -0,0 +1,87 @@
+#include "check.h"
+#include "schedule.h"
+
+#include <string.h>
+
+#define SUN 0
+#define MON 1
+#define FRI 5
+#define SAT 6
+
+static ScheduleRule parse(const char *text) {
+  ScheduleRule rule = {};
+  CHECK(scheduleParseRule(text, strlen(text), rule));
+  return rule;
+}
+
+static void testParsesRules() {
+  ScheduleRule rule = parse("mon-fri 23:00-06:30 topup");
+  CHECK_EQ(rule.days, 0x3E);
+  CHECK_EQ(rule.start, 23 * 60);
+  CHECK_EQ(rule.end, 6 * 60 + 30);
+  CHECK_EQ(rule.action, SCHEDULE_TOP_UP);
+
+  CHECK_EQ(parse("daily 17:00-21:00 peak").days, 0x7F);
+  CHECK_EQ(parse("sat,sun 00:00-00:00 topup").days, 0x41);
+  CHECK_EQ(parse("fri-mon 10:00-11:00 peak").days, 0x63);  // Wraps past Saturday
+  CHECK_EQ(parse("mon,wed-thu 10:00-11:00 peak\r\n").days, 0x1A);
+  CHECK_EQ(parse("off").days, 0);
+}
+
+static void testRejectsBadRules() {
+  const char *bad[] = {
+    "", "mon", "mon 23:00-06:00", "mon 23:00-06:00 boost", "xyz 23:00-06:00 topup",
+    "mon 24:00-06:00 topup", "mon 23:60-06:00 topup", "mon 2300-0600 topup",
+    "mon, 23:00-06:00 topup", "mon-", "mon-fri  23:00-06:00 topup",
+  };
+  for (const char *text : bad) {
+    ScheduleRule rule = { 1, SCHEDULE_PEAK, 1, 2 };
+    CHECK(!scheduleParseRule(text, strlen(text), rule));
+    CHECK_EQ(rule.start, 1);  // Untouched
+  }
+}
+
+static void testFormatRoundTrips() {
+  const char *rules[] = { "daily 17:00-21:00 peak", "sun,sat 00:00-00:00 topup", "mon,tue,wed,thu,fri 23:00-06:30 topup", "off" };
+  for (const char *text : rules) {
+    char out[SCHEDULE_RULE_TEXT_MAX];
+    scheduleFormatRule(parse(text), out, sizeof(out));
+    CHECK(strcmp(out, text) == 0);
+  }
+
+  char out[SCHEDULE_RULE_TEXT_MAX];
+  scheduleFormatRule({ 0x3F, SCHEDULE_TOP_UP, 0, 0 }, out, sizeof(out));
+  CHECK(strlen(out) < sizeof(out) - 1);
+  scheduleFormatRule({ 0x7F, 9, 0, 0 }, out, sizeof(out));  // Corrupt action
+  CHECK(strcmp(out, "off") == 0);
+}
+
+static void testWindowsAcrossMidnight() {
+  ScheduleRule rules[] = { parse("fri 23:00-06:00 topup") };
+  CHECK_EQ(scheduleActionAt(rules, 1, FRI, 22 * 60 + 59), SCHEDULE_NONE);
+  CHECK_EQ(scheduleActionAt(rules, 1, FRI, 23 * 60), SCHEDULE_TOP_UP);
+  CHECK_EQ(scheduleActionAt(rules, 1, SAT, 5 * 60 + 59), SCHEDULE_TOP_UP);
+  CHECK_EQ(scheduleActionAt(rules, 1, SAT, 6 * 60), SCHEDULE_NONE);
+  CHECK_EQ(scheduleActionAt(rules, 1, SAT, 23 * 60), SCHEDULE_NONE);
+  CHECK_EQ(scheduleActionAt(rules, 1, FRI, 3 * 60), SCHEDULE_NONE);  // Thursday's night is not scheduled
+}
+
+static void testPeakWinsOverlaps() {
+  ScheduleRule rules[SCHEDULE_RULES] = {
+    parse("daily 00:00-00:00 topup"),
+    parse("mon-fri 17:00-21:00 peak"),
+  };
+  CHECK_EQ(scheduleActionAt(rules, SCHEDULE_RULES, MON, 12 * 60), SCHEDULE_TOP_UP);
+  CHECK_EQ(scheduleActionAt(rules, SCHEDULE_RULES, MON, 18 * 60), SCHEDULE_PEAK);
+  CHECK_EQ(scheduleActionAt(rules, SCHEDULE_RULES, SUN, 18 * 60), SCHEDULE_TOP_UP);
+  CHECK_EQ(scheduleActionAt(rules, 0, MON, 18 * 60), SCHEDULE_NONE);
+}
+
+int main() {
+  RUN_TEST(testParsesRules);
+  RUN_TEST(testRejectsBadRules);
+  RUN_TEST(testFormatRoundTrips);
+  RUN_TEST(testWindowsAcrossMidnight);
+  RUN_TEST(testPeakWinsOverlaps);
+  return checkResult();
+}
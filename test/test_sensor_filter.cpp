@@ -0,0 +1,77 @@
+#include "check.h"
+#include "sensor_filter.h"
+
+static void feed(SensorFilter &f, bool high, int samples) {
+  for (int i = 0; i < samples; i++) {
+    sensorFilterSample(f, high);
+  }
+}
+
+static void testSeedSetsState() {
+  SensorFilter f = { 4, 0, 0, false };
+  sensorFilterSeed(f, true);
+  CHECK(f.state);
+  CHECK_EQ(f.highCount, SAMPLE_WINDOW);
+  sensorFilterSeed(f, false);
+  CHECK(!f.state);
+  CHECK_EQ(f.highCount, 0);
+}
+
+static void testSwitchesAtVoteThresholds() {
+  SensorFilter f = { 4, 0, 0, false };
+  sensorFilterSeed(f, false);
+  feed(f, true, SAMPLE_WET_COUNT - 1);
+  CHECK(!f.state);
+  feed(f, true, 1);
+  CHECK(f.state);
+
+  feed(f, true, SAMPLE_WINDOW);
+  feed(f, false, SAMPLE_WINDOW - SAMPLE_DRY_COUNT - 1);
+  CHECK(f.state);
+  feed(f, false, 1);
+  CHECK(!f.state);
+}
+
+static void testRejectsAlternatingNoise() {
+  SensorFilter f = { 4, 0, 0, false };
+  sensorFilterSeed(f, false);
+  for (int i = 0; i < 1000; i++) {
+    sensorFilterSample(f, i & 1);
+    CHECK(!f.state);
+  }
+  sensorFilterSeed(f, true);
+  for (int i = 0; i < 1000; i++) {
+    sensorFilterSample(f, i & 1);
+    CHECK(f.state);
+  }
+}
+
+static void testHighCountMatchesWindow() {
+  SensorFilter f = { 4, 0, 0, false };
+  sensorFilterSeed(f, false);
+  uint32_t pattern = 0x2F5A9;
+  for (int i = 0; i < 200; i++) {
+    sensorFilterSample(f, (pattern >> (i % 19)) & 1);
+    int bits = 0;
+    for (int b = 0; b < SAMPLE_WINDOW; b++) {
+      bits += (f.history >> b) & 1;
+    }
+    CHECK_EQ(f.highCount, bits);
+  }
+}
+
+static void testReadFindsPin() {
+  SensorFilter filters[] = { { 4, 0, 0, true }, { 5, 0, 0, false } };
+  CHECK(sensorFilterRead(filters, 2, 4));
+  CHECK(!sensorFilterRead(filters, 2, 5));
+  CHECK(!sensorFilterRead(filters, 2, 9));
+}
+
+int main() {
+  RUN_TEST(testSeedSetsState);
+  RUN_TEST(testSwitchesAtVoteThresholds);
+  RUN_TEST(testRejectsAlternatingNoise);
+  RUN_TEST(testHighCountMatchesWindow);
+  RUN_TEST(testReadFindsPin);
+  return checkResult();
+}
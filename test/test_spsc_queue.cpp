@@ -0,0 +1,92 @@
+#include "check.h"
+#include "spsc_queue.h"
+
+#include <thread>
+
+static void testFifoOrder() {
+  SpscQueue<int, 4> queue;
+  CHECK(spscPush(queue, 1));
+  CHECK(spscPush(queue, 2));
+  CHECK(spscPush(queue, 3));
+  CHECK_EQ(spscCount(queue), 3u);
+  int item = 0;
+  CHECK(spscPop(queue, item));
+  CHECK_EQ(item, 1);
+  CHECK(spscPop(queue, item));
+  CHECK_EQ(item, 2);
+  CHECK(spscPop(queue, item));
+  CHECK_EQ(item, 3);
+  CHECK(!spscPop(queue, item));
+  CHECK_EQ(item, 3);  // Untouched
+}
+
+static void testFullQueueRejects() {
+  SpscQueue<int, 4> queue;
+  for (int i = 0; i < 4; i++) {
+    CHECK(spscPush(queue, i));
+  }
+  CHECK(!spscPush(queue, 99));
+  int item = 0;
+  CHECK(spscPop(queue, item));
+  CHECK_EQ(item, 0);
+  CHECK(spscPush(queue, 4));  // A slot is free again
+  for (int i = 1; i <= 4; i++) {
+    CHECK(spscPop(queue, item));
+    CHECK_EQ(item, i);
+  }
+}
+
+static void testIndexWraparound() {
+  SpscQueue<int, 2> queue;
+  queue.head = 0xFFFFFFFFu;
+  queue.tail = 0xFFFFFFFFu;
+  CHECK(spscPush(queue, 7));
+  CHECK(spscPush(queue, 8));
+  CHECK(!spscPush(queue, 9));
+  CHECK_EQ(spscCount(queue), 2u);
+  int item = 0;
+  CHECK(spscPop(queue, item));
+  CHECK_EQ(item, 7);
+  CHECK(spscPop(queue, item));
+  CHECK_EQ(item, 8);
+  CHECK_EQ(spscCount(queue), 0u);
+}
+
+// One producer and one consumer thread: every item arrives once, in order.
+// Each side yields when the queue is full or empty, so the test stays quick
+// on a machine with a single core.
+static void testConcurrentProducerConsumer() {
+  static SpscQueue<uint32_t, 16> queue;
+  const uint32_t count = 20000;
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < count;) {
+      if (spscPush(queue, i)) {
+        i++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint32_t expected = 0;
+  bool ordered = true;
+  while (expected < count) {
+    uint32_t item;
+    if (spscPop(queue, item)) {
+      ordered = ordered && item == expected;
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  CHECK(ordered);
+  CHECK_EQ(spscCount(queue), 0u);
+}
+
+int main() {
+  RUN_TEST(testFifoOrder);
+  RUN_TEST(testFullQueueRejects);
+  RUN_TEST(testIndexWraparound);
+  RUN_TEST(testConcurrentProducerConsumer);
+  return checkResult();
+}
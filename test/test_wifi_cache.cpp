@@ -0,0 +1,119 @@
+#include "check.h"
+#include "wifi_cache.h"
+
+#include <string.h>
+
+static WifiCache sample() {
+  WifiCache cache = {};
+  const uint8_t bssid[6] = { 0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56 };
+  for (int i = 0; i < 6; i++) {
+    cache.bssid[i] = bssid[i];
+  }
+  cache.channel = 6;
+  cache.ip = 0x2A01A8C0;  // 192.168.1.42
+  cache.gateway = 0x0101A8C0;
+  cache.subnet = 0x00FFFFFF;
+  cache.dns = 0x0101A8C0;
+  wifiCacheSeal(cache, wifiCacheKey("tank-net", "secret"));
+  return cache;
+}
+
+static void testSealedCacheIsUsable() {
+  CHECK(wifiCacheUsable(sample(), wifiCacheKey("tank-net", "secret")));
+}
+
+static void testOtherCredentialsVoidTheCache() {
+  WifiCache cache = sample();
+  CHECK(!wifiCacheUsable(cache, wifiCacheKey("tank-net", "secret2")));
+  CHECK(!wifiCacheUsable(cache, wifiCacheKey("other-net", "secret")));
+  CHECK(wifiCacheKey("ab", "c") != wifiCacheKey("a", "bc"));
+}
+
+static void testCorruptOrEmptyCacheIsRejected() {
+  uint32_t key = wifiCacheKey("tank-net", "secret");
+  WifiCache cache = sample();
+  cache.ip ^= 1;  // Flipped in flash
+  CHECK(!wifiCacheUsable(cache, key));
+
+  WifiCache blank = {};
+  CHECK(!wifiCacheUsable(blank, key));
+  wifiCacheSeal(blank, key);  // Sealed, but holds no join
+  CHECK(!wifiCacheUsable(blank, key));
+
+  cache = sample();
+  cache.channel = 15;
+  wifiCacheSeal(cache, key);
+  CHECK(!wifiCacheUsable(cache, key));
+}
+
+static void testLeaseIsReusedOnlySoOften() {
+  uint32_t key = wifiCacheKey("tank-net", "secret");
+  WifiCache cache = sample();
+  cache.joins = WIFI_CACHE_MAX_JOINS - 1;
+  wifiCacheSeal(cache, key);
+  CHECK(wifiCacheUsable(cache, key));
+  cache.joins = WIFI_CACHE_MAX_JOINS;
+  wifiCacheSeal(cache, key);
+  CHECK(!wifiCacheUsable(cache, key));
+}
+
+// What the sketch does from boot to got-IP: load the record from flash,
+// count a fast join and write it back, then save the join the station made.
+// `flash` stands in for the cache file. Returns whether the join was fast.
+static bool bootAndJoin(WifiCache &flash, uint32_t key) {
+  WifiCache loaded;
+  memcpy(&loaded, &flash, sizeof(loaded));
+  bool fast = wifiCacheUsable(loaded, key);
+  if (fast) {
+    wifiCacheCountJoin(loaded, key);
+    flash = loaded;
+  }
+  WifiCache join = sample();  // Same AP and lease as before
+  wifiCacheSealJoin(join, loaded, fast, key);
+  if (!wifiCacheSame(join, loaded)) {
+    flash = join;
+  }
+  return fast;
+}
+
+static void testJoinCountSurvivesReboots() {
+  uint32_t key = wifiCacheKey("tank-net", "secret");
+  WifiCache flash = sample();
+  for (int boot = 1; boot <= WIFI_CACHE_MAX_JOINS; boot++) {
+    CHECK(bootAndJoin(flash, key));
+    CHECK_EQ(flash.joins, boot);
+  }
+  // The lease has been reused enough: this boot asks DHCP again
+  CHECK(!wifiCacheUsable(flash, key));
+  CHECK(!bootAndJoin(flash, key));
+  CHECK_EQ(flash.joins, 0);
+  CHECK(wifiCacheUsable(flash, key));
+}
+
+static void testReconnectDoesNotCountAJoin() {
+  uint32_t key = wifiCacheKey("tank-net", "secret");
+  WifiCache flash = sample();
+  CHECK(bootAndJoin(flash, key));
+  WifiCache join = sample();  // The SDK rejoined on its own, no new joinWiFi()
+  wifiCacheSealJoin(join, flash, true, key);
+  CHECK(wifiCacheSame(join, flash));
+}
+
+static void testSameIgnoresTheChecksum() {
+  WifiCache a = sample();
+  WifiCache b = sample();
+  CHECK(wifiCacheSame(a, b));
+  b.channel = 11;
+  CHECK(!wifiCacheSame(a, b));
+}
+
+int main() {
+  RUN_TEST(testSealedCacheIsUsable);
+  RUN_TEST(testOtherCredentialsVoidTheCache);
+  RUN_TEST(testCorruptOrEmptyCacheIsRejected);
+  RUN_TEST(testLeaseIsReusedOnlySoOften);
+  RUN_TEST(testJoinCountSurvivesReboots);
+  RUN_TEST(testReconnectDoesNotCountAJoin);
+  RUN_TEST(testSameIgnoresTheChecksum);
+  return checkResult();
+}
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Compress the pages in web/ into web_assets.h.
+
+Each file becomes a gzip'd PROGMEM array plus an entry in WEB_ASSETS, which
+the sketch registers with the web server. index.html is served at "/", every
+other page at "/<name>" without the extension. Run this after editing
+anything in web/ and commit the regenerated header.
+"""
+import gzip
+import hashlib
+import os
+import re
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+WEB_DIR = os.path.join(ROOT, 'web')
+OUTPUT = os.path.join(ROOT, 'web_assets.h')
+
+CONTENT_TYPES = {
+    '.html': 'text/html',
+    '.js': 'application/javascript',
+    '.css': 'text/css',
+}
+
+
+def main():
+    names = sorted(n for n in os.listdir(WEB_DIR) if os.path.splitext(n)[1] in CONTENT_TYPES)
+    out = [
+        '// Generated by tools/build_web_assets.py from web/ - do not edit.',
+        '#pragma once',
+        '',
+        'struct WebAsset {',
+        '  const char *path;',
+        '  const char *contentType;',
+        '  const uint8_t *data;  // gzip, in flash',
+        '  size_t length;',
+        '  const char *etag;',
+        '};',
+        '',
+    ]
+    entries = []
+    for name in names:
+        base, ext = os.path.splitext(name)
+        raw = open(os.path.join(WEB_DIR, name), 'rb').read()
+        data = gzip.compress(raw, 9, mtime=0)
+        ident = re.sub(r'\W', '_', name).upper() + '_GZ'
+        path = '/' if name == 'index.html' else '/' + base
+        etag = hashlib.sha1(raw).hexdigest()[:12]
+
+        out.append('// %s: %d bytes, %d gzip\'d' % (name, len(raw), len(data)))
+        out.append('static const uint8_t %s[] PROGMEM = {' % ident)
+        for i in range(0, len(data), 16):
+            out.append('  ' + ', '.join('0x%02x' % b for b in data[i:i + 16]) + ',')
+        out.append('};')
+        out.append('')
+        entries.append('  { "%s", "%s", %s, sizeof(%s), "\\"%s\\"" },'
+                       % (path, CONTENT_TYPES[ext], ident, ident, etag))
+
+    out.append('static const WebAsset WEB_ASSETS[] = {')
+    out.extend(entries)
+    out.append('};')
+    out.append('')
+    with open(OUTPUT, 'w') as f:
+        f.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Sign firmware update manifests.
+
+  ota_sign.py genkey
+      Creates ota_private.pem (keep it out of git) and ota_key.h, the public
+      half the sketch builds in. Without ota_key.h the firmware refuses OTA.
+
+  ota_sign.py manifest VERSION URL IMAGE [ROLLBACK_URL ROLLBACK_IMAGE]
+      Prints a signed manifest for IMAGE, served at URL. IMAGE is the file
+      exactly as served (a .bin or a gzip'd .bin.gz). VERSION is dotted
+      decimal and must be newer than the firmware it replaces; units refuse
+      anything else. The rollback image is reinstalled if the new one fails
+      its health check after the update.
+
+Publish the image and the manifest, then send the manifest URL to the
+unit's "ota" MQTT command. Signing uses the openssl command line tool.
+"""
+import hashlib
+import os
+import re
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+PRIVATE_KEY = os.path.join(ROOT, 'ota_private.pem')
+PUBLIC_HEADER = os.path.join(ROOT, 'ota_key.h')
+
+
+def openssl(*args, data=None):
+    return subprocess.run(('openssl',) + args, input=data, stdout=subprocess.PIPE, check=True).stdout
+
+
+def genkey():
+    if os.path.exists(PRIVATE_KEY):
+        sys.exit('%s already exists' % PRIVATE_KEY)
+    openssl('genpkey', '-algorithm', 'RSA', '-pkeyopt', 'rsa_keygen_bits:2048', '-out', PRIVATE_KEY)
+    os.chmod(PRIVATE_KEY, 0o600)
+    pem = openssl('pkey', '-in', PRIVATE_KEY, '-pubout').decode()
+    lines = ['// Generated by tools/ota_sign.py genkey - public key for OTA manifests.',
+             '#pragma once', '',
+             'static const char OTA_PUBLIC_KEY[] PROGMEM = R"KEY(',
+             pem.strip(),
+             ')KEY";', '']
+    with open(PUBLIC_HEADER, 'w') as f:
+        f.write('\n'.join(lines))
+    print('wrote %s and %s' % (PRIVATE_KEY, PUBLIC_HEADER))
+
+
+def digests(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    return hashlib.md5(data).hexdigest(), hashlib.sha256(data).hexdigest()
+
+
+def manifest(version, url, image, rollback_url=None, rollback_image=None):
+    if len(version) >= 16 or len(url) >= 128 or (rollback_url and len(rollback_url) >= 128):
+        sys.exit('version must be under 16 characters, URLs under 128')
+    if not re.fullmatch(r'\d+(\.\d+)*', version):
+        sys.exit('version must be dotted decimal, e.g. 1.4.0')
+    body = 'version=%s\nurl=%s\nmd5=%s\nsha256=%s\n' % ((version, url) + digests(image))
+    if rollback_url:
+        body += 'rollback_url=%s\nrollback_md5=%s\nrollback_sha256=%s\n' % ((rollback_url,) + digests(rollback_image))
+    signature = openssl('dgst', '-sha256', '-sign', PRIVATE_KEY, data=body.encode())
+    sys.stdout.write(body + 'sig=%s\n' % signature.hex())
+
+
+def main():
+    args = sys.argv[1:]
+    if args == ['genkey']:
+        genkey()
+    elif len(args) in (4, 6) and args[0] == 'manifest':
+        manifest(*args[1:])
+    else:
+        sys.exit(__doc__)
+
+
+if __name__ == '__main__':
+    main()
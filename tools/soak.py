@@ -0,0 +1,336 @@
+#!/usr/bin/env python3
+"""Soak-test a unit built with -DSOAK_TEST=1 and report how it held up.
+
+  soak.py run DEVICE [options]
+      Loads DEVICE (host name or IP) for --duration seconds. It fetches /
+      and /setup at --http-rate requests per second in total, and if
+      --broker is given publishes override commands at --mqtt-rate per
+      second. At the end it writes a JSON report to --report. The report
+      has the host-side request latencies and errors, the command acks,
+      and every window the unit recorded in /soak.json. Those windows
+      hold free heap, largest block, fragmentation, loop latency and
+      reconnect counters. Resets are detected from the uptime going
+      backwards.
+
+  soak.py compare BEFORE.json AFTER.json
+      Prints the summaries of two reports side by side, to compare
+      firmware builds before rolling one out.
+
+The default payloads only switch the pump off and back to automatic, so a
+unit with a pump connected keeps working normally. Only the standard
+library is used; MQTT is spoken over a plain socket (no TLS).
+"""
+import argparse
+import json
+import socket
+import struct
+import sys
+import threading
+import time
+import urllib.request
+
+PAGES = ('/', '/setup')
+
+
+class MqttClient:
+    """Just enough MQTT 3.1.1 to publish, subscribe and keep alive at QoS 0."""
+
+    KEEPALIVE_S = 60
+
+    def __init__(self, host, port, client_id, user=None, password=None):
+        self.sock = socket.create_connection((host, port), timeout=10)
+        self.lock = threading.Lock()
+        self.next_id = 1
+        flags = 0x02  # Clean session
+        payload = self._string(client_id)
+        if user:
+            flags |= 0x80
+            payload += self._string(user)
+            if password:
+                flags |= 0x40
+                payload += self._string(password)
+        header = self._string('MQTT') + bytes([4, flags]) + struct.pack('>H', self.KEEPALIVE_S)
+        self._send(0x10, header + payload)
+        kind, body = self._read()
+        if kind != 0x20 or len(body) < 2 or body[1] != 0:
+            sys.exit('broker refused the connection (rc=%s)' % (body[1] if len(body) > 1 else '?'))
+
+    @staticmethod
+    def _string(text):
+        data = text.encode()
+        return struct.pack('>H', len(data)) + data
+
+    def _send(self, kind, body):
+        length = len(body)
+        encoded = bytearray()
+        while True:
+            byte = length % 128
+            length //= 128
+            encoded.append(byte | (0x80 if length else 0))
+            if not length:
+                break
+        with self.lock:
+            self.sock.sendall(bytes([kind]) + bytes(encoded) + body)
+
+    def _recv(self, count):
+        data = b''
+        while len(data) < count:
+            chunk = self.sock.recv(count - len(data))
+            if not chunk:
+                raise ConnectionError('broker closed the connection')
+            data += chunk
+        return data
+
+    def _read(self):
+        kind = self._recv(1)[0] & 0xF0
+        length, shift = 0, 0
+        while True:
+            byte = self._recv(1)[0]
+            length |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        return kind, self._recv(length)
+
+    def publish(self, topic, payload):
+        self._send(0x30, self._string(topic) + payload.encode())
+
+    def subscribe(self, topic):
+        self._send(0x82, struct.pack('>H', self.next_id) + self._string(topic) + b'\x00')
+        self.next_id += 1
+
+    def ping(self):
+        self._send(0xC0, b'')
+
+    def messages(self):
+        """Yields (topic, payload) for every PUBLISH until the socket closes."""
+        self.sock.settimeout(None)
+        while True:
+            kind, body = self._read()
+            if kind == 0x30:
+                length = struct.unpack('>H', body[:2])[0]
+                yield body[2:2 + length].decode(), body[2 + length:].decode(errors='replace')
+
+
+def fetch_json(device, path, timeout=10):
+    with urllib.request.urlopen('http://%s%s' % (device, path), timeout=timeout) as response:
+        return json.loads(response.read())
+
+
+def percentile(values, fraction):
+    if not values:
+        return None
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def paced(rate, deadline, stop):
+    """Yields at `rate` per second until `deadline`, without drifting."""
+    interval = 1.0 / rate
+    due = time.monotonic()
+    while not stop.is_set() and due < deadline:
+        yield
+        due += interval
+        stop.wait(max(0.0, due - time.monotonic()))
+
+
+def load_http(device, rate, deadline, stop, results):
+    for n, _ in enumerate(paced(rate, deadline, stop)):
+        path = PAGES[n % len(PAGES)]
+        entry = results[path]
+        started = time.monotonic()
+        try:
+            with urllib.request.urlopen('http://%s%s' % (device, path), timeout=10) as response:
+                response.read()
+            entry['latencies'].append(time.monotonic() - started)
+        except OSError:
+            entry['errors'] += 1
+
+
+def load_mqtt(client, base, payloads, rate, deadline, stop, counts):
+    last_ping = time.monotonic()
+    for n, _ in enumerate(paced(rate, deadline, stop)):
+        try:
+            client.publish(base + 'override', payloads[n % len(payloads)])
+            counts['sent'] += 1
+            if time.monotonic() - last_ping > MqttClient.KEEPALIVE_S / 2:
+                client.ping()
+                last_ping = time.monotonic()
+        except OSError:
+            counts['errors'] += 1
+            return
+
+
+def read_acks(client, counts):
+    try:
+        for topic, payload in client.messages():
+            if topic.endswith('/ack'):
+                counts['acked' if json.loads(payload).get('ok') else 'rejected'] += 1
+    except (OSError, ValueError, ConnectionError):
+        pass
+
+
+class DeviceSamples:
+    """Collects /soak.json windows across polls, and across resets."""
+
+    def __init__(self):
+        self.samples = []
+        self.resets = 0
+        self.last_uptime = None
+        self.seen = set()
+        self.firmware = None
+        self.device = None
+
+    def poll(self, device):
+        try:
+            report = fetch_json(device, '/soak.json')
+        except (OSError, ValueError):
+            return False
+        self.firmware = report['fw']
+        self.device = report['device']
+        if self.last_uptime is not None and report['uptime'] < self.last_uptime:
+            self.resets += 1
+            self.seen = set()
+        self.last_uptime = report['uptime']
+        for sample in report['samples']:
+            key = (self.resets, sample['t'])
+            if key not in self.seen:
+                self.seen.add(key)
+                self.samples.append(dict(sample, boot=self.resets))
+        return True
+
+
+def summarise(samples, resets):
+    if not samples:
+        return {'resets': resets}
+
+    def growth(name):
+        # Counters restart with the unit, so sum the growth within each boot
+        total = 0
+        for boot in set(s['boot'] for s in samples):
+            values = [s[name] for s in samples if s['boot'] == boot]
+            total += values[-1] - values[0]
+        return total
+
+    return {
+        'windows': len(samples),
+        'resets': resets,
+        'heapMin': min(s['heapMin'] for s in samples),
+        'heapMinLast': samples[-1]['heapMin'],
+        'blockMin': min(s['blockMin'] for s in samples),
+        'fragMax': max(s['fragMax'] for s in samples),
+        'loopMaxUs': max(s['loopMaxUs'] for s in samples),
+        'wifiReconnects': growth('wifiReconnects'),
+        'mqttReconnects': growth('mqttConnects'),
+        'mqttFailures': growth('mqttFailures'),
+    }
+
+
+def run(args):
+    samples = DeviceSamples()
+    if not samples.poll(args.device):
+        sys.exit('no /soak.json on %s - is it a -DSOAK_TEST=1 build?' % args.device)
+    print('soaking %s (%s, firmware %s) for %d s' % (args.device, samples.device, samples.firmware, args.duration))
+
+    stop = threading.Event()
+    started = time.time()
+    deadline = time.monotonic() + args.duration
+    http = {path: {'latencies': [], 'errors': 0} for path in PAGES}
+    mqtt = {'sent': 0, 'acked': 0, 'rejected': 0, 'errors': 0}
+    threads = []
+    if args.http_rate > 0:
+        threads.append(threading.Thread(target=load_http, args=(args.device, args.http_rate, deadline, stop, http)))
+    if args.broker:
+        host, _, port = args.broker.partition(':')
+        client = MqttClient(host, int(port or 1883), 'soak-%d' % int(started), args.user, args.password)
+        base = '%s/%s/' % (args.prefix, samples.device)
+        client.subscribe(base + 'ack')
+        threading.Thread(target=read_acks, args=(client, mqtt), daemon=True).start()
+        threads.append(threading.Thread(target=load_mqtt, args=(client, base, args.payloads.split(','),
+                                                                args.mqtt_rate, deadline, stop, mqtt)))
+    for thread in threads:
+        thread.start()
+
+    try:
+        while time.monotonic() < deadline:
+            stop.wait(min(args.poll, max(0.0, deadline - time.monotonic())))
+            if not samples.poll(args.device):
+                print('  /soak.json unreachable')
+            else:
+                summary = summarise(samples.samples, samples.resets)
+                print('  %d windows, heap min %s, frag max %s%%, loop max %s us, resets %d' % (
+                    summary.get('windows', 0), summary.get('heapMin'), summary.get('fragMax'),
+                    summary.get('loopMaxUs'), samples.resets))
+    except KeyboardInterrupt:
+        print('stopped early')
+    stop.set()
+    for thread in threads:
+        thread.join()
+    samples.poll(args.device)
+
+    report = {
+        'device': samples.device,
+        'firmware': samples.firmware,
+        'started': time.strftime('%Y-%m-%dT%H:%M:%SZ', time.gmtime(started)),
+        'durationS': round(time.time() - started),
+        'load': {'httpRate': args.http_rate, 'mqttRate': args.mqtt_rate if args.broker else 0,
+                 'payloads': args.payloads.split(',')},
+        'http': {path: {'requests': len(entry['latencies']) + entry['errors'], 'errors': entry['errors'],
+                        'p50Ms': round(1000 * (percentile(entry['latencies'], 0.5) or 0), 1),
+                        'p95Ms': round(1000 * (percentile(entry['latencies'], 0.95) or 0), 1),
+                        'maxMs': round(1000 * max(entry['latencies'] or [0]), 1)}
+                 for path, entry in http.items()},
+        'mqtt': mqtt,
+        'summary': summarise(samples.samples, samples.resets),
+        'samples': samples.samples,
+    }
+    with open(args.report, 'w') as f:
+        json.dump(report, f, indent=1)
+    print('wrote %s' % args.report)
+
+
+def compare(before_path, after_path):
+    before = json.load(open(before_path))
+    after = json.load(open(after_path))
+    rows = [('firmware', before.get('firmware'), after.get('firmware'))]
+    for key in ('windows', 'resets', 'heapMin', 'heapMinLast', 'blockMin', 'fragMax', 'loopMaxUs',
+                'wifiReconnects', 'mqttReconnects', 'mqttFailures'):
+        rows.append((key, before['summary'].get(key), after['summary'].get(key)))
+    for path in PAGES:
+        for key in ('p95Ms', 'maxMs', 'errors'):
+            rows.append(('%s %s' % (path, key), before['http'][path][key], after['http'][path][key]))
+    print('%-18s %14s %14s %10s' % ('', before_path[-14:], after_path[-14:], 'change'))
+    for name, old, new in rows:
+        change = ''
+        if isinstance(old, (int, float)) and isinstance(new, (int, float)):
+            change = '%+g' % (new - old)
+        print('%-18s %14s %14s %10s' % (name, old, new, change))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest='command', required=True)
+    soak = commands.add_parser('run')
+    soak.add_argument('device')
+    soak.add_argument('--duration', type=int, default=3600, help='seconds (default 3600)')
+    soak.add_argument('--http-rate', type=float, default=2.0, help='page requests per second (default 2)')
+    soak.add_argument('--broker', help='HOST[:PORT] of the broker the unit uses')
+    soak.add_argument('--user')
+    soak.add_argument('--password')
+    soak.add_argument('--prefix', default='waterpump', help='topic prefix configured on the unit')
+    soak.add_argument('--mqtt-rate', type=float, default=1.0, help='override commands per second (default 1)')
+    soak.add_argument('--payloads', default='OFF,AUTO', help='override payloads to cycle through')
+    soak.add_argument('--poll', type=float, default=60.0, help='seconds between /soak.json polls')
+    soak.add_argument('--report', default='soak.json')
+    diff = commands.add_parser('compare')
+    diff.add_argument('before')
+    diff.add_argument('after')
+    args = parser.parse_args()
+    if args.command == 'run':
+        run(args)
+    else:
+        compare(args.before, args.after)
+
+
+if __name__ == '__main__':
+    main()
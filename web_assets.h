@@ -0,0 +1,205 @@
+// Generated by tools/build_web_assets.py from web/ - do not edit.
+#pragma once
+
+struct WebAsset {
+  const char *path;
+  const char *contentType;
+  const uint8_t *data;  // gzip, in flash
+  size_t length;
+  const char *etag;
+};
+
+// index.html: 3641 bytes, 1423 gzip'd
+static const uint8_t INDEX_HTML_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x95, 0x57, 0x59, 0x6f, 0xdb, 0x46,
+  0x10, 0x7e, 0xd7, 0xaf, 0x18, 0x07, 0x68, 0x48, 0xc2, 0x36, 0xe9, 0x34, 0x68, 0x1e, 0xa2, 0x23,
+  0x48, 0x83, 0xa8, 0x76, 0x21, 0x5b, 0x69, 0xa4, 0xc6, 0x28, 0x8a, 0x3e, 0xac, 0xc9, 0x95, 0xb8,
+  0x35, 0xb5, 0xcb, 0x72, 0x97, 0x52, 0x8c, 0xc2, 0xff, 0xbd, 0x33, 0xc3, 0xc3, 0xa4, 0x2c, 0x25,
+  0xa8, 0x01, 0xc3, 0x3b, 0xb3, 0x73, 0x71, 0x8e, 0x6f, 0xc7, 0xa3, 0xd4, 0x6d, 0xb2, 0xc9, 0xe8,
+  0xce, 0x24, 0x0f, 0x93, 0xc1, 0x28, 0x7d, 0x3d, 0xf9, 0x60, 0xb4, 0x2b, 0x4c, 0x96, 0xc9, 0x02,
+  0x16, 0x4e, 0xb8, 0xd2, 0x8e, 0x22, 0xe4, 0x0e, 0x46, 0x4e, 0xdc, 0x65, 0x12, 0xee, 0x4c, 0x91,
+  0xc8, 0x62, 0xec, 0xbd, 0xf2, 0x26, 0x23, 0x57, 0xe0, 0x6f, 0x3a, 0xb9, 0x72, 0x72, 0x33, 0x8a,
+  0xf0, 0x40, 0x44, 0xa3, 0x42, 0x64, 0x84, 0x02, 0x83, 0x4a, 0x2a, 0x99, 0xdc, 0xaa, 0xa9, 0x02,
+  0xb4, 0xad, 0x65, 0xec, 0x64, 0x82, 0x77, 0x09, 0xb1, 0x41, 0x25, 0x63, 0x6f, 0xa7, 0x56, 0xca,
+  0x9b, 0x9c, 0x57, 0xbc, 0x9e, 0xd2, 0xf5, 0x6f, 0xcb, 0xe5, 0x11, 0xa5, 0xcd, 0x3f, 0xce, 0x1d,
+  0x56, 0x9a, 0x99, 0x1d, 0x2c, 0xa4, 0xb6, 0xa6, 0xe8, 0x29, 0x64, 0x66, 0x77, 0x58, 0xfe, 0x52,
+  0xad, 0xd3, 0x43, 0x0a, 0x29, 0xf2, 0x8f, 0x78, 0x90, 0x5b, 0x99, 0xf5, 0x8d, 0x13, 0xe7, 0xb0,
+  0xf0, 0xa7, 0x72, 0x93, 0xb7, 0x99, 0xec, 0xa8, 0xe4, 0xc8, 0xff, 0x8e, 0x86, 0xec, 0x29, 0x58,
+  0xe2, 0x1c, 0xd6, 0x58, 0xc4, 0xa9, 0x4c, 0x4a, 0x2c, 0xcf, 0xad, 0xd2, 0x89, 0xd9, 0xed, 0x65,
+  0x97, 0x58, 0x87, 0xf5, 0xa6, 0xd9, 0x9e, 0xf0, 0xea, 0x68, 0x96, 0x66, 0xc2, 0x3a, 0xf8, 0x5c,
+  0x6a, 0xf8, 0x62, 0xb2, 0x72, 0xd3, 0x8f, 0x2c, 0xc3, 0xbb, 0xa9, 0xca, 0xf6, 0x13, 0x10, 0x71,
+  0xcb, 0xe0, 0x21, 0x51, 0x5b, 0x96, 0x73, 0x42, 0xdf, 0x5b, 0x6c, 0x9c, 0x08, 0x19, 0x55, 0xb3,
+  0xd1, 0x57, 0x2a, 0xeb, 0x54, 0xfc, 0xff, 0xba, 0xec, 0x8b, 0xc8, 0x4a, 0x79, 0xa0, 0xc9, 0x3e,
+  0x98, 0x4d, 0x9e, 0x49, 0x6c, 0x15, 0xa0, 0x70, 0xfa, 0xf9, 0x5e, 0x11, 0xe7, 0x48, 0x1a, 0xf0,
+  0x0a, 0x96, 0x6a, 0xef, 0xab, 0x48, 0x81, 0x98, 0x87, 0x75, 0x3e, 0x3c, 0xc4, 0x99, 0xb4, 0x10,
+  0xc1, 0xa5, 0x29, 0xfb, 0x7d, 0x13, 0xf3, 0xcd, 0x37, 0x4a, 0x4b, 0x59, 0x7c, 0xe6, 0xad, 0x28,
+  0xf5, 0x71, 0x67, 0x0b, 0xa5, 0x63, 0x09, 0x5c, 0x82, 0x69, 0x99, 0xf5, 0x5b, 0xcf, 0xd2, 0x1d,
+  0x71, 0x8f, 0x65, 0xdf, 0xc6, 0x85, 0xca, 0xdd, 0x64, 0x10, 0x45, 0x55, 0x53, 0x81, 0xb2, 0x90,
+  0x97, 0x16, 0x3b, 0x06, 0xcc, 0x16, 0xa7, 0x3c, 0xda, 0x59, 0x10, 0x16, 0x94, 0x83, 0x38, 0x15,
+  0x7a, 0x2d, 0x6d, 0x08, 0xb7, 0xa9, 0xc2, 0x2a, 0xb8, 0x54, 0x82, 0x35, 0xf1, 0xbd, 0x74, 0xa4,
+  0x82, 0x4d, 0xa4, 0x99, 0x95, 0x8b, 0xb5, 0x24, 0x63, 0x2b, 0x81, 0x09, 0x85, 0x3b, 0x11, 0xdf,
+  0x83, 0x33, 0x90, 0x23, 0x64, 0x28, 0xbd, 0x86, 0x48, 0xe4, 0x2a, 0xb2, 0xdc, 0xee, 0x20, 0x74,
+  0x02, 0xf7, 0x52, 0xe6, 0x16, 0x5c, 0xf1, 0x40, 0x97, 0x28, 0x57, 0xc8, 0xb8, 0x9a, 0xe7, 0x70,
+  0xb0, 0x15, 0x05, 0x6c, 0x61, 0x0c, 0x17, 0x43, 0x3e, 0xd2, 0x40, 0x20, 0xa5, 0xf1, 0x53, 0x6a,
+  0x06, 0x9a, 0x6c, 0x19, 0xab, 0x52, 0xc7, 0x4e, 0x19, 0x0d, 0x56, 0x3a, 0x5f, 0x25, 0x67, 0xe0,
+  0xe4, 0x57, 0x17, 0xc0, 0xbf, 0x18, 0x57, 0x8c, 0xfd, 0xa8, 0x5d, 0xb8, 0x96, 0xee, 0x63, 0x26,
+  0xe9, 0xf8, 0xf3, 0xc3, 0x55, 0x82, 0x32, 0x41, 0x48, 0x32, 0x84, 0x67, 0xc8, 0x43, 0x43, 0x44,
+  0x0d, 0xe1, 0xb1, 0x63, 0x2a, 0x35, 0x3b, 0xdf, 0xa2, 0x91, 0x01, 0x70, 0x20, 0x36, 0xdc, 0x0e,
+  0xf1, 0x48, 0x1e, 0x2a, 0x50, 0x3a, 0x43, 0x16, 0x1d, 0xe0, 0x1d, 0x78, 0x7f, 0x60, 0x4d, 0xe1,
+  0x2d, 0x78, 0x37, 0xc6, 0x0b, 0x5a, 0x29, 0x46, 0x21, 0x92, 0xa2, 0xc3, 0x51, 0x29, 0x1a, 0x2a,
+  0x12, 0xc2, 0xbf, 0x24, 0xf3, 0x1e, 0xbd, 0x6f, 0x25, 0x8b, 0x5d, 0x69, 0x51, 0x11, 0x4f, 0xc2,
+  0x0c, 0x3b, 0x24, 0x4d, 0x87, 0xef, 0x8b, 0x57, 0xc8, 0x43, 0xf2, 0x96, 0x21, 0x6c, 0x2a, 0xca,
+  0x8c, 0x23, 0x59, 0x7c, 0xbc, 0x59, 0xcc, 0x3f, 0xc3, 0xf4, 0xfd, 0xef, 0xb3, 0x25, 0x29, 0xa3,
+  0x7b, 0x12, 0x85, 0x53, 0xf0, 0xe0, 0x87, 0x8e, 0x01, 0xc6, 0x21, 0xd2, 0xe7, 0xfc, 0xa3, 0xe2,
+  0xfc, 0x86, 0x7d, 0xcd, 0xa7, 0xd3, 0x8e, 0x54, 0x05, 0x3e, 0xec, 0x86, 0x7b, 0xe8, 0x14, 0x7c,
+  0x1b, 0x52, 0xfb, 0x14, 0x2a, 0x91, 0xa4, 0x05, 0x7e, 0x43, 0x05, 0xac, 0xee, 0x05, 0x95, 0x4c,
+  0x66, 0xf4, 0x9a, 0xe7, 0x8b, 0x64, 0xce, 0x61, 0x36, 0xbf, 0xf9, 0x05, 0xa6, 0x57, 0xb3, 0x59,
+  0x2d, 0x14, 0x74, 0x12, 0xce, 0x38, 0x75, 0x86, 0x25, 0xd5, 0x46, 0x4b, 0xce, 0xa1, 0x26, 0x97,
+  0xce, 0xe4, 0x65, 0x8e, 0xe4, 0xd2, 0xe4, 0xe7, 0x25, 0x85, 0x9a, 0x4b, 0x71, 0x8f, 0xf4, 0x27,
+  0xfc, 0xe3, 0xc1, 0xe3, 0x9f, 0x54, 0x22, 0x52, 0xfd, 0x8b, 0x6d, 0xa9, 0x15, 0x79, 0x25, 0x1c,
+  0x9b, 0xe5, 0x1b, 0x38, 0x19, 0x8f, 0xa1, 0xd4, 0x89, 0x5c, 0x29, 0x2d, 0x93, 0xaa, 0xd0, 0xb5,
+  0xbb, 0x55, 0x53, 0x14, 0x6d, 0xa6, 0x75, 0x5d, 0x6e, 0xe6, 0x30, 0x9d, 0xcd, 0x6f, 0xab, 0x64,
+  0xd5, 0x16, 0x42, 0x67, 0xa6, 0xea, 0xab, 0x4c, 0xfc, 0x57, 0x01, 0x67, 0x6e, 0x16, 0x6d, 0x94,
+  0xae, 0xf2, 0xd2, 0x14, 0xa0, 0x01, 0x3f, 0xae, 0x70, 0x4d, 0xcc, 0x9e, 0xe9, 0x55, 0x3a, 0x8f,
+  0xf4, 0xb5, 0xd8, 0x75, 0x4b, 0x42, 0x42, 0x8c, 0x93, 0x11, 0xb1, 0x8d, 0x9b, 0x2b, 0x40, 0x21,
+  0x53, 0xcb, 0xc3, 0xcb, 0x97, 0x4d, 0x51, 0x4e, 0xc6, 0x3c, 0x1c, 0x01, 0xac, 0xa4, 0x8b, 0x53,
+  0x1a, 0x62, 0xeb, 0x07, 0x43, 0x80, 0x7a, 0xa2, 0x2d, 0x18, 0x9d, 0x3d, 0xc0, 0x06, 0x0b, 0x80,
+  0xa7, 0x6a, 0x8e, 0x5c, 0x21, 0xb4, 0x55, 0xd4, 0xe5, 0x16, 0x8d, 0xd7, 0xa3, 0x55, 0x99, 0x1b,
+  0x0e, 0xf6, 0x46, 0xa0, 0x0a, 0xa6, 0x0a, 0x85, 0x53, 0x44, 0xb1, 0x9c, 0x30, 0x8d, 0x3d, 0xa3,
+  0xd7, 0x2e, 0x0d, 0x70, 0x6c, 0x5d, 0x59, 0x68, 0x0a, 0x94, 0x26, 0x93, 0x76, 0x06, 0xb4, 0xf7,
+  0x82, 0x20, 0x7c, 0x8e, 0x98, 0x50, 0x00, 0xdb, 0x60, 0x0c, 0x3f, 0x0e, 0xe1, 0x24, 0xd3, 0x42,
+  0xf8, 0x8c, 0x5f, 0x9e, 0xea, 0x4c, 0x2f, 0x70, 0x4b, 0x10, 0x44, 0xf6, 0xd6, 0x89, 0x0e, 0xd0,
+  0xbf, 0xa0, 0x00, 0xaa, 0xc0, 0x56, 0xa6, 0xf8, 0x28, 0xe2, 0xd4, 0x6f, 0xbf, 0xc4, 0x77, 0x4d,
+  0x7d, 0x39, 0xba, 0xd3, 0x31, 0x78, 0x0d, 0x7c, 0x7a, 0x58, 0x02, 0x17, 0xaa, 0x84, 0x2a, 0xd1,
+  0x60, 0x27, 0x33, 0x7d, 0xf7, 0xcd, 0x99, 0x3c, 0x24, 0xff, 0xcd, 0xa9, 0x84, 0x53, 0x0e, 0xa0,
+  0xf9, 0x79, 0xa6, 0x7c, 0x68, 0xc4, 0x9e, 0x39, 0x71, 0x4f, 0x23, 0xe6, 0xbe, 0x3f, 0x62, 0xde,
+  0x13, 0xe6, 0x7b, 0xdc, 0x61, 0xdc, 0x4d, 0xc7, 0x40, 0xb1, 0x7e, 0x82, 0x83, 0x50, 0x21, 0x06,
+  0x17, 0x97, 0xcb, 0xeb, 0x19, 0x96, 0xb1, 0xca, 0x17, 0x5b, 0xe2, 0x27, 0xc3, 0xeb, 0x75, 0x48,
+  0xdb, 0x73, 0x25, 0x36, 0x1d, 0x67, 0x98, 0x39, 0xbe, 0xd7, 0x41, 0xfa, 0x77, 0xfc, 0x08, 0x8d,
+  0x29, 0xfa, 0x2d, 0xa2, 0x6e, 0x2a, 0x75, 0xa7, 0x2e, 0x45, 0x53, 0x17, 0x6a, 0xab, 0x22, 0xac,
+  0xdf, 0x06, 0xec, 0xf2, 0x1f, 0x2f, 0x2e, 0x9a, 0xc6, 0x82, 0x22, 0xfc, 0xdb, 0x1a, 0xed, 0xd7,
+  0xca, 0xd4, 0x95, 0x41, 0xf3, 0x35, 0x87, 0x62, 0x39, 0x16, 0x0a, 0x7d, 0xda, 0x01, 0xf7, 0xfb,
+  0x5e, 0xf0, 0x15, 0x78, 0x26, 0xe7, 0xfa, 0xf0, 0xc0, 0xdb, 0x02, 0x82, 0x4f, 0xc8, 0xa7, 0xee,
+  0xc0, 0xb7, 0x7b, 0x41, 0x7b, 0x8b, 0xc5, 0xa9, 0x4e, 0xd7, 0x52, 0x68, 0x1e, 0x77, 0x7c, 0xfb,
+  0xb6, 0xeb, 0x33, 0xa8, 0xca, 0x49, 0x37, 0x0b, 0x97, 0x24, 0x72, 0x5b, 0xdf, 0x59, 0x26, 0xb8,
+  0x86, 0xe7, 0x3d, 0x2c, 0xa9, 0x57, 0x07, 0x32, 0x5c, 0x1d, 0x3f, 0x61, 0x91, 0x70, 0xbf, 0xe8,
+  0xca, 0x34, 0x8b, 0xc2, 0x19, 0xb5, 0x07, 0x12, 0x0b, 0x7a, 0x50, 0x13, 0xda, 0x44, 0x5e, 0xbf,
+  0xc1, 0x84, 0xee, 0x03, 0x4f, 0xda, 0x73, 0xf0, 0xb4, 0x2c, 0x90, 0x8f, 0x96, 0x82, 0x11, 0x5c,
+  0x50, 0x87, 0x9d, 0x53, 0x4c, 0xd7, 0xc2, 0xa5, 0x61, 0x61, 0x10, 0x36, 0xfd, 0xae, 0x48, 0x04,
+  0x6f, 0x2e, 0x2a, 0x93, 0x2d, 0x02, 0xee, 0x55, 0xa7, 0x7e, 0xd8, 0xeb, 0xd2, 0x10, 0x4e, 0xd4,
+  0xdb, 0x03, 0x02, 0x9a, 0xdc, 0xc1, 0xad, 0xbc, 0x5b, 0x30, 0x8d, 0x58, 0x6f, 0xdf, 0x46, 0x11,
+  0x25, 0x27, 0x33, 0xb1, 0x20, 0xdd, 0x30, 0x35, 0xb8, 0xdb, 0xa0, 0x71, 0x5c, 0x46, 0xea, 0x57,
+  0x87, 0x45, 0x43, 0xa3, 0x4d, 0x2e, 0x35, 0x5a, 0x78, 0x2a, 0x14, 0xd5, 0x13, 0x73, 0x23, 0x8a,
+  0x2b, 0x7c, 0xd8, 0x8b, 0xad, 0xc8, 0x7c, 0x5a, 0x14, 0xb0, 0xa6, 0xdd, 0x7d, 0x01, 0x1e, 0x7b,
+  0x46, 0x36, 0xd2, 0x5a, 0x5c, 0x5b, 0x7a, 0x76, 0x24, 0x19, 0xe2, 0x15, 0xe0, 0xd7, 0xc5, 0xfc,
+  0x26, 0xcc, 0x45, 0x61, 0xa5, 0x2f, 0xc3, 0x44, 0x38, 0x11, 0x04, 0xfb, 0x06, 0xe2, 0xcc, 0x58,
+  0xb9, 0x1f, 0x46, 0xdb, 0xd5, 0x27, 0x1c, 0x41, 0x13, 0x00, 0x66, 0xba, 0x0d, 0xad, 0x33, 0x3d,
+  0x67, 0xd4, 0xf0, 0x17, 0x4f, 0xd5, 0xa0, 0x2a, 0x9a, 0xd2, 0xf9, 0x75, 0xda, 0xce, 0xe0, 0xa7,
+  0xe6, 0xfa, 0x91, 0xd3, 0xda, 0x9d, 0xbb, 0xe1, 0xa0, 0x07, 0xfd, 0x83, 0x36, 0xd5, 0xc3, 0xc1,
+  0x41, 0x6f, 0xe8, 0x0c, 0x9b, 0x81, 0xcc, 0xf1, 0x2b, 0x51, 0x2d, 0xab, 0x51, 0x8a, 0xad, 0xc4,
+  0x4b, 0x99, 0x43, 0xd7, 0xc0, 0xa5, 0xc5, 0x0f, 0xc2, 0x98, 0x93, 0x42, 0xad, 0x1c, 0xec, 0x94,
+  0x43, 0x09, 0x07, 0xa2, 0xf3, 0x7a, 0xe0, 0x1e, 0xd9, 0xec, 0x8f, 0xa3, 0x88, 0xff, 0x49, 0x44,
+  0x90, 0xa7, 0xff, 0x18, 0x07, 0xff, 0x01, 0x5b, 0x1a, 0x8a, 0xf3, 0x39, 0x0e, 0x00, 0x00,
+};
+
+// setup.html: 4213 bytes, 1483 gzip'd
+static const uint8_t SETUP_HTML_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xad, 0x58, 0x6d, 0x53, 0xdb, 0x46,
+  0x10, 0xfe, 0xee, 0x5f, 0xb1, 0x65, 0xa6, 0x23, 0x7b, 0xc0, 0x92, 0xc0, 0x21, 0x6d, 0x82, 0xec,
+  0x19, 0x42, 0x48, 0x60, 0x06, 0x37, 0x6e, 0xec, 0x74, 0x32, 0xc9, 0xe4, 0xc3, 0x21, 0x9d, 0x6c,
+  0x15, 0xe9, 0x4e, 0x73, 0x77, 0xc2, 0x31, 0x6d, 0xfe, 0x7b, 0x77, 0x4f, 0xb2, 0x91, 0x40, 0x06,
+  0xb7, 0xd3, 0x0f, 0x80, 0x6f, 0xf7, 0xb9, 0x7d, 0xbb, 0x7d, 0x33, 0xc1, 0xc2, 0x64, 0xe9, 0x28,
+  0xb8, 0x96, 0xd1, 0x6a, 0xd4, 0x09, 0x16, 0x83, 0xd1, 0x99, 0x14, 0x71, 0x32, 0x2f, 0x14, 0x33,
+  0x89, 0x14, 0x30, 0xe5, 0xa6, 0xc8, 0x03, 0x0f, 0xe9, 0x41, 0x2c, 0x55, 0x06, 0x2c, 0x24, 0xf2,
+  0xd0, 0xf1, 0x34, 0xbb, 0xe5, 0x0e, 0x64, 0xdc, 0x2c, 0x64, 0x34, 0x74, 0x72, 0xa9, 0x8d, 0x83,
+  0xf7, 0x0d, 0xbb, 0x4e, 0x39, 0x5c, 0x4b, 0x15, 0x71, 0x35, 0x74, 0x0e, 0x9d, 0x51, 0x60, 0x14,
+  0xfe, 0x2c, 0x46, 0x28, 0xc7, 0x24, 0x62, 0x1e, 0x78, 0xf8, 0x99, 0xce, 0x7f, 0xb0, 0xb4, 0xe0,
+  0xe5, 0xc9, 0x43, 0x48, 0xa7, 0xc4, 0x45, 0xa3, 0xe9, 0xf4, 0xf2, 0x2d, 0x52, 0x22, 0x7b, 0x08,
+  0x12, 0x91, 0x17, 0x06, 0xcc, 0x2a, 0xe7, 0x43, 0xc7, 0xf0, 0xef, 0xc6, 0x01, 0xc1, 0x32, 0xfc,
+  0xac, 0x75, 0x12, 0xa1, 0x72, 0xf6, 0x3d, 0xe5, 0x62, 0x6e, 0x16, 0x43, 0x67, 0xf0, 0xca, 0x19,
+  0x95, 0xd7, 0x1a, 0xd2, 0x26, 0x4c, 0xeb, 0x25, 0x1a, 0xd3, 0x2e, 0x31, 0xaf, 0xb8, 0x6b, 0xa9,
+  0xcb, 0x24, 0x4e, 0x88, 0xf6, 0x50, 0x32, 0xe4, 0x29, 0x0b, 0xf9, 0x42, 0xa6, 0xd6, 0xa9, 0x42,
+  0x84, 0x0b, 0x26, 0xe6, 0x3c, 0x6a, 0xd5, 0x38, 0xfe, 0x7d, 0x36, 0xc3, 0xa0, 0xa9, 0x5b, 0xae,
+  0x76, 0x70, 0xc3, 0xe2, 0x76, 0x71, 0xc4, 0x8a, 0x9d, 0x48, 0x65, 0xda, 0x85, 0x8a, 0x22, 0xbb,
+  0x26, 0x41, 0xa5, 0xd8, 0x1c, 0x71, 0x28, 0x34, 0x11, 0xf4, 0x02, 0x24, 0x7c, 0xe8, 0xbc, 0x3c,
+  0x3e, 0x1e, 0x1c, 0xb7, 0x4a, 0xfe, 0x84, 0x46, 0xd0, 0xb5, 0xe7, 0xad, 0x2d, 0xf4, 0x03, 0x5b,
+  0x0f, 0xff, 0x8f, 0xa0, 0x3f, 0x0a, 0xf8, 0xe1, 0xbf, 0x0b, 0xf8, 0x5b, 0x7e, 0x9b, 0x84, 0x1c,
+  0xee, 0xb3, 0x06, 0x12, 0xcc, 0xc7, 0xc8, 0x52, 0x9d, 0x51, 0xbf, 0xe5, 0xc6, 0x4c, 0xe6, 0x49,
+  0x08, 0x13, 0xc5, 0xe3, 0xe4, 0xfb, 0xf3, 0x5e, 0xe7, 0x16, 0xd7, 0xb0, 0xf0, 0x68, 0xd0, 0x6a,
+  0xc9, 0x7b, 0x25, 0xa9, 0x54, 0x9e, 0x13, 0x38, 0x27, 0xd8, 0x43, 0x79, 0x4d, 0x8f, 0x85, 0x14,
+  0x7c, 0x7b, 0x1a, 0xcc, 0xae, 0xa6, 0xf7, 0x5a, 0x34, 0x4f, 0x79, 0x68, 0x2a, 0xd1, 0x26, 0xd5,
+  0x54, 0x84, 0x32, 0xb7, 0xa5, 0x7b, 0x4b, 0x25, 0x36, 0x74, 0x7c, 0x67, 0xf4, 0x21, 0x8e, 0x03,
+  0xaf, 0xa4, 0x3e, 0x62, 0x63, 0x8d, 0x4e, 0x12, 0x21, 0x78, 0x04, 0x31, 0xd6, 0x27, 0x57, 0xb9,
+  0x4a, 0x84, 0xd9, 0x8a, 0x3e, 0x72, 0x46, 0x6f, 0x8a, 0x24, 0x35, 0xfd, 0x44, 0xc0, 0xd9, 0x69,
+  0x0d, 0xe6, 0x95, 0x86, 0xb4, 0x19, 0xfd, 0x46, 0xc9, 0x1b, 0xae, 0x60, 0x7a, 0x71, 0xda, 0x3f,
+  0x84, 0x77, 0x75, 0x25, 0xcf, 0x85, 0xaa, 0x66, 0x51, 0x23, 0x60, 0xc7, 0x98, 0x22, 0x3a, 0xb9,
+  0x43, 0xc4, 0x8b, 0x5f, 0x5b, 0xe3, 0x74, 0xc5, 0x6f, 0x79, 0x8a, 0x65, 0x28, 0xb4, 0x54, 0x5b,
+  0x62, 0xa5, 0x2d, 0xb3, 0x35, 0x5c, 0xef, 0x52, 0xc9, 0x0c, 0xe8, 0x65, 0x62, 0xc2, 0x05, 0xd7,
+  0x4f, 0x46, 0x4e, 0x71, 0xad, 0x0b, 0xc5, 0xc1, 0x28, 0x26, 0x74, 0x54, 0x84, 0xe8, 0x67, 0xf7,
+  0xd4, 0xef, 0x3d, 0x15, 0xbf, 0x4f, 0x29, 0x82, 0xb5, 0x14, 0x98, 0x83, 0x51, 0xa2, 0x0d, 0x13,
+  0x21, 0xdf, 0x2d, 0x8e, 0x53, 0xc3, 0x94, 0x81, 0xd2, 0xb5, 0xee, 0xcf, 0xbd, 0x5d, 0x3a, 0x41,
+  0x4a, 0x60, 0x7b, 0xaf, 0xea, 0x07, 0x7e, 0xd5, 0x0f, 0x5e, 0xb5, 0x97, 0xee, 0xd4, 0xc8, 0xfc,
+  0x3f, 0x69, 0x90, 0xf9, 0x83, 0x86, 0x73, 0xe8, 0xfb, 0xad, 0x1a, 0x3e, 0xb2, 0x25, 0x7c, 0xe4,
+  0x2c, 0xc2, 0x97, 0x05, 0x0c, 0xf2, 0x79, 0x96, 0x9b, 0xd5, 0x2e, 0x7a, 0x42, 0x96, 0x5a, 0xec,
+  0x03, 0x3f, 0xb6, 0xf7, 0xb5, 0x07, 0x8a, 0xde, 0x15, 0x69, 0xba, 0xa3, 0x1e, 0x82, 0xee, 0xac,
+  0x06, 0x73, 0x65, 0x09, 0x63, 0x6e, 0xe8, 0xe1, 0xf3, 0x22, 0xd5, 0x5c, 0x7b, 0x57, 0x3b, 0x05,
+  0x2e, 0xc6, 0x8b, 0x13, 0x7b, 0xa1, 0x55, 0x57, 0xb3, 0x21, 0xf8, 0x30, 0x84, 0xad, 0x4d, 0x61,
+  0x22, 0x97, 0xa8, 0x7d, 0x2c, 0x23, 0xbe, 0x25, 0xd5, 0x73, 0x02, 0xb4, 0x66, 0xfa, 0x69, 0xba,
+  0x64, 0x2b, 0x0d, 0x52, 0x3c, 0x95, 0xe4, 0x24, 0x39, 0x03, 0x9d, 0x72, 0x9e, 0x3f, 0x95, 0xd7,
+  0x57, 0xc9, 0x7c, 0x61, 0x4a, 0x18, 0x2c, 0x17, 0x5c, 0x60, 0x1f, 0x4e, 0x77, 0xcc, 0xec, 0x33,
+  0x99, 0x65, 0x4c, 0x44, 0x70, 0xc5, 0x0c, 0x17, 0xe1, 0x0a, 0xba, 0x99, 0xee, 0xed, 0x36, 0xe8,
+  0xd0, 0xb1, 0xea, 0xd2, 0x3a, 0xff, 0x7c, 0xff, 0x3e, 0x03, 0xb7, 0xe4, 0xe0, 0x6f, 0xb3, 0xc9,
+  0xce, 0x23, 0x5a, 0x98, 0x7c, 0x97, 0xf9, 0x3c, 0x4b, 0x32, 0x0e, 0x5f, 0xf0, 0x85, 0xa0, 0x3b,
+  0xf9, 0x30, 0xbd, 0xfc, 0x0c, 0xb3, 0x2f, 0xbd, 0xe7, 0x85, 0x9b, 0xbb, 0xa7, 0x57, 0x8d, 0xb3,
+  0xf3, 0x59, 0xff, 0xf0, 0xec, 0x7c, 0x3a, 0x3b, 0x18, 0x0f, 0xdc, 0x63, 0xd7, 0x3f, 0x18, 0x1f,
+  0xfa, 0xf4, 0xd7, 0x6b, 0x1f, 0x40, 0x53, 0x6c, 0x57, 0x51, 0x91, 0xf2, 0xc6, 0x24, 0x54, 0x48,
+  0xd0, 0x4d, 0xb8, 0x67, 0xb7, 0xb4, 0xa6, 0x59, 0xba, 0xb8, 0xce, 0x12, 0x34, 0xac, 0x7a, 0xcf,
+  0x29, 0x6d, 0x77, 0x88, 0xa7, 0x9d, 0x0f, 0x6f, 0xe4, 0x1b, 0xd9, 0x60, 0xe5, 0x01, 0xc3, 0x9e,
+  0x17, 0x84, 0x98, 0x18, 0xa3, 0x88, 0x12, 0xe8, 0xe2, 0xe2, 0xf5, 0x78, 0xdc, 0xb7, 0xbf, 0x01,
+  0x7b, 0x41, 0x91, 0xff, 0x9d, 0x73, 0x76, 0x13, 0x78, 0x16, 0x71, 0x00, 0xdc, 0x9d, 0xbb, 0x15,
+  0x3c, 0x93, 0xa2, 0x1f, 0xab, 0x04, 0x8e, 0x06, 0xaf, 0x7d, 0xbf, 0xef, 0xbf, 0x7c, 0x3d, 0xf0,
+  0xcb, 0x1b, 0x6b, 0x70, 0x47, 0xaa, 0x0a, 0x2a, 0x69, 0x6a, 0xd9, 0x4f, 0x2e, 0xe0, 0xcc, 0xee,
+  0x17, 0x98, 0x57, 0x89, 0x88, 0xe4, 0x52, 0xe3, 0xa8, 0x4a, 0x53, 0x30, 0x0b, 0xec, 0xbb, 0x4c,
+  0xdc, 0x60, 0xfa, 0xe2, 0x02, 0x60, 0x53, 0x0e, 0x49, 0x2b, 0x90, 0x39, 0x17, 0x27, 0x80, 0x03,
+  0x8a, 0x6c, 0xd8, 0x5c, 0x61, 0x40, 0x83, 0x1c, 0xaf, 0x69, 0x54, 0xa7, 0xa9, 0x25, 0xd0, 0x7d,
+  0xaa, 0xde, 0x98, 0xda, 0xbd, 0x1b, 0x78, 0xb9, 0x75, 0x74, 0x86, 0x54, 0xaa, 0x4d, 0x5a, 0x6d,
+  0x31, 0xd3, 0x34, 0xd8, 0xaa, 0x06, 0x59, 0x18, 0x0a, 0xd6, 0x5c, 0xa2, 0xf3, 0x46, 0xc2, 0xc7,
+  0xcf, 0xd0, 0x7d, 0x3f, 0xb9, 0xfc, 0x30, 0xe8, 0xb9, 0x70, 0x8a, 0x90, 0x2c, 0x47, 0x71, 0x28,
+  0x53, 0x15, 0x42, 0xa3, 0x4a, 0x5c, 0x8a, 0x11, 0xbc, 0x64, 0xd4, 0x16, 0x32, 0x79, 0x4b, 0x3d,
+  0x28, 0xd1, 0x56, 0x73, 0x4e, 0x83, 0x56, 0xaa, 0xce, 0x82, 0xa5, 0x31, 0x30, 0x01, 0x08, 0x54,
+  0x27, 0x80, 0xc3, 0x28, 0xc2, 0xd3, 0xca, 0x2c, 0x08, 0x8a, 0xf2, 0xcb, 0x08, 0x94, 0xbb, 0x87,
+  0x57, 0x2e, 0x33, 0x1e, 0x59, 0xe5, 0xe1, 0xc0, 0xe1, 0xa6, 0x0a, 0x0b, 0x01, 0xc3, 0x94, 0x33,
+  0x05, 0x09, 0x16, 0x9e, 0xc4, 0xec, 0x53, 0x1b, 0x37, 0xaa, 0x92, 0x2a, 0x5f, 0xca, 0xb0, 0x1b,
+  0x0c, 0x0e, 0x56, 0x6b, 0x9b, 0xd8, 0xcd, 0x2b, 0x35, 0x98, 0x76, 0x4b, 0xa9, 0x7e, 0xaf, 0xd5,
+  0x51, 0x89, 0x36, 0x40, 0x2c, 0x4d, 0x37, 0xd7, 0x3b, 0xc4, 0x65, 0xe1, 0x8d, 0x90, 0xcb, 0x94,
+  0x47, 0xb8, 0xad, 0x6d, 0xd3, 0x87, 0x98, 0xf5, 0xb3, 0x96, 0xc6, 0xea, 0x50, 0x25, 0xb9, 0x19,
+  0x75, 0x30, 0x2c, 0xd0, 0xbd, 0x25, 0x6f, 0xb0, 0xdb, 0xf9, 0xf8, 0x82, 0x10, 0xc0, 0x4b, 0xfc,
+  0xb3, 0xbf, 0xdf, 0x83, 0xbf, 0x3a, 0x00, 0x91, 0x0c, 0x8b, 0x8c, 0x0b, 0xe3, 0xce, 0xb9, 0x39,
+  0x4f, 0x39, 0x7d, 0x7c, 0xb3, 0xba, 0x8c, 0xba, 0x55, 0x8a, 0xf7, 0x5c, 0x5a, 0x63, 0xd4, 0xc5,
+  0x6c, 0x7c, 0x05, 0xfb, 0x43, 0xd8, 0xdb, 0x5a, 0x75, 0x04, 0xdf, 0x83, 0x7d, 0x94, 0xbf, 0x0f,
+  0x7b, 0x8d, 0x02, 0x7c, 0xf1, 0xcb, 0x7a, 0xaf, 0x18, 0x60, 0x43, 0x0b, 0xae, 0xd5, 0x68, 0xef,
+  0xa4, 0xf3, 0xa3, 0x13, 0x73, 0x5c, 0x04, 0xba, 0x8e, 0xc7, 0xf2, 0x04, 0x0d, 0xa7, 0x6f, 0x47,
+  0xa8, 0x0c, 0xb3, 0x47, 0x74, 0x63, 0xdc, 0x4d, 0x6d, 0x1b, 0xec, 0x2a, 0xb4, 0x11, 0x33, 0xcc,
+  0x14, 0x4a, 0x80, 0x72, 0xff, 0xc4, 0xf9, 0xde, 0xed, 0x9d, 0xc0, 0x8f, 0x47, 0xb8, 0xb0, 0xf4,
+  0x85, 0xdc, 0x8c, 0xd1, 0xcd, 0x8d, 0x4f, 0x54, 0x68, 0xfa, 0xab, 0xff, 0xed, 0x04, 0x99, 0xb1,
+  0x4b, 0xdf, 0x6f, 0x5c, 0x5b, 0x8a, 0x88, 0x09, 0xed, 0xb1, 0x62, 0xd8, 0xb6, 0x55, 0x67, 0x59,
+  0x42, 0xc9, 0xa4, 0xbd, 0xbf, 0xc6, 0xa2, 0x63, 0xc9, 0xa0, 0xcd, 0xbd, 0xc6, 0xa0, 0xe3, 0xc9,
+  0x53, 0x01, 0xad, 0xb6, 0x67, 0x34, 0x1e, 0xc3, 0x86, 0xdf, 0x07, 0xb1, 0xc1, 0x1a, 0x7b, 0xb3,
+  0x64, 0x54, 0xda, 0xec, 0xab, 0xd6, 0xf5, 0x59, 0x42, 0xc9, 0xb4, 0x89, 0x53, 0xe3, 0xd9, 0x73,
+  0xc9, 0xc2, 0x25, 0xb5, 0xc6, 0xc0, 0xd3, 0x3d, 0xb9, 0x9c, 0x15, 0xfa, 0xeb, 0xd1, 0x37, 0x17,
+  0x57, 0x23, 0x6a, 0x52, 0x11, 0x82, 0x7e, 0x0a, 0xdd, 0x90, 0xd9, 0xad, 0xf3, 0x52, 0x94, 0xd8,
+  0xda, 0x5e, 0x58, 0x13, 0x55, 0xa3, 0xae, 0x83, 0x45, 0x2b, 0x5e, 0x23, 0x58, 0x44, 0x28, 0x99,
+  0xf7, 0xab, 0x51, 0x0d, 0x70, 0x4f, 0x6c, 0x80, 0x64, 0xfe, 0x18, 0x23, 0x2b, 0x77, 0xd6, 0x8b,
+  0x49, 0x0d, 0xb1, 0x26, 0x6d, 0x00, 0xb4, 0x51, 0x34, 0xf9, 0x44, 0xa9, 0x7c, 0xd9, 0xec, 0x01,
+  0x75, 0x57, 0x36, 0xc4, 0xf5, 0xcb, 0x2e, 0x1b, 0x2f, 0x68, 0xcf, 0x35, 0x56, 0x35, 0x03, 0x1f,
+  0x22, 0x2a, 0x72, 0x09, 0xc4, 0x49, 0x56, 0xe3, 0xe3, 0xa9, 0x8a, 0xfb, 0x5d, 0xfd, 0x35, 0xee,
+  0x88, 0x18, 0xba, 0xb6, 0xa2, 0x28, 0x27, 0xcf, 0x19, 0x66, 0x7e, 0x2d, 0xcb, 0x91, 0x7e, 0x00,
+  0x09, 0xe5, 0x7a, 0xfc, 0xd5, 0x16, 0x92, 0x43, 0x85, 0xf4, 0x6d, 0x23, 0x82, 0x48, 0x94, 0xf6,
+  0x58, 0x36, 0xf8, 0x83, 0x33, 0xbf, 0xaa, 0xed, 0xc0, 0xb3, 0xff, 0x60, 0x08, 0x3c, 0xfb, 0xdf,
+  0x86, 0xce, 0x3f, 0x4a, 0x76, 0xbd, 0xf0, 0x75, 0x10, 0x00, 0x00,
+};
+
+static const WebAsset WEB_ASSETS[] = {
+  { "/", "text/html", INDEX_HTML_GZ, sizeof(INDEX_HTML_GZ), "\"97478ef6788d\"" },
+  { "/setup", "text/html", SETUP_HTML_GZ, sizeof(SETUP_HTML_GZ), "\"007c9243b252\"" },
+};